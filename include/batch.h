@@ -0,0 +1,23 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "grid.h"
+#include "scenario.h"
+
+class PathCache;
+
+struct BatchResult {
+    SearchResult result;
+    double latencyUs = 0;
+};
+
+// Runs independent queries on a pool of threads. The grid is shared
+// read-only, every thread owns a SearchSpace and pulls small chunks of
+// queries until none are left. threads == 0 uses all cores. Results
+// come back in query order. With a cache, queries it already holds
+// are not searched again. Flow fields are built once per goal instead.
+std::vector<BatchResult> searchBatch(const WeightedGrid& grid, Algorithm algorithm,
+                                     const std::vector<Query>& queries, unsigned threads = 0,
+                                     const SearchOptions& options = {}, PathCache* cache = nullptr);
+
+#endif // BATCH_H
@@ -0,0 +1,73 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include "grid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Connected components of the open cells, so a query whose goal lies
+// outside the component of its start is rejected without a search.
+// Labelling unions the runs of open cells in each row with the runs
+// they touch in the row above. Edits update the labels: an opened cell
+// joins the components around it, a closed one only costs a search if
+// its neighbors no longer meet around it, and then only as much as the
+// pieces split off.
+//
+// Eight directions without corner cutting or cutting past one open
+// cell connect exactly what four do, only cutting always connects more.
+class Components {
+public:
+    static constexpr int NONE = -1;
+
+    Components(const Grid& grid, const SearchOptions& options = {});
+
+    // Components computed for more steps still tell which cells no
+    // path connects
+    bool covers(const SearchOptions& options) const {
+        return always(this->mOptions) || !always(options);
+    }
+
+    // Id of the component of an open cell, NONE for an obstacle. Ids are
+    // stable until an edit merges or splits the component, not dense.
+    int component(int cell) const {
+        int label = this->labels[cell];
+        return label < 0 ? NONE : this->labelComponent[label];
+    }
+    std::size_t size(int component) const { return this->sizes[component]; }
+    std::size_t count() const { return this->mCount; }
+
+    // False if no path leads from start to goal. A start inside an
+    // obstacle reaches the components of its neighbors.
+    bool connected(const Grid& grid, Coordinates start, Coordinates goal) const;
+
+    // Call after the obstacle of id changed in grid
+    void update(const Grid& grid, Coordinates id);
+
+private:
+    SearchOptions mOptions;
+    // Cells carry labels, labels belong to components. Merging moves the
+    // labels of the smaller component, so a lookup stays two reads. A
+    // component is named after one of its labels, which has the lists.
+    std::vector<int> labels;
+    std::vector<int> labelComponent;
+    std::vector<std::vector<int>> members; // Labels of a component
+    std::vector<std::size_t> sizes;        // Cells of a component
+    std::size_t mCount = 0;
+
+    // Split searches: the cells each one reached and who reached a cell first
+    std::vector<std::vector<int>> reached;
+    std::vector<std::uint32_t> stamp;
+    std::vector<std::uint8_t> owner;
+    std::uint32_t generation = 0;
+
+    static bool always(const SearchOptions& options) {
+        return options.connectivity == Connectivity::eight && options.cornerCutting == CornerCutting::always;
+    }
+    int newComponent();
+    void merge(int a, int b);
+    void split(const Grid& grid, int cell, int component);
+};
+
+#endif // COMPONENTS_H
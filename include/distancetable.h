@@ -0,0 +1,38 @@
+#ifndef DISTANCETABLE_H
+#define DISTANCETABLE_H
+
+#include "grid.h"
+
+#include <cstddef>
+#include <vector>
+
+// Costs from every source to every target, the same Dijkstra costs as
+// WeightedGrid::dijkstraSearch. One search per source settles the
+// targets and stops after the last one instead of one search per pair.
+// Sources run on a pool of threads, each with its own SearchSpace.
+class DistanceTable {
+public:
+    static constexpr Cost UNREACHABLE = ~Cost(0);
+
+    // Builds on threads threads, 0 uses all cores
+    DistanceTable(const WeightedGrid& grid, std::vector<Coordinates> sources, std::vector<Coordinates> targets,
+                  const SearchOptions& options = {}, unsigned threads = 0);
+
+    const std::vector<Coordinates>& sources() const { return this->mSources; }
+    const std::vector<Coordinates>& targets() const { return this->mTargets; }
+    // In the fixed point of Cost, UNREACHABLE without a path
+    Cost cost(std::size_t source, std::size_t target) const {
+        return this->costs[source * this->mTargets.size() + target];
+    }
+    // Row major, one row per source
+    const std::vector<Cost>& matrix() const { return this->costs; }
+    // Cells taken off the frontiers of all searches
+    std::size_t expanded() const { return this->mExpanded; }
+
+private:
+    std::vector<Coordinates> mSources, mTargets;
+    std::vector<Cost> costs;
+    std::size_t mExpanded = 0;
+};
+
+#endif // DISTANCETABLE_H
@@ -0,0 +1,72 @@
+#ifndef DSTAR_H
+#define DSTAR_H
+
+#include "frontier.h"
+#include "grid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// D* Lite (Koenig and Likhachev), an incremental search that keeps its
+// state between plans. It searches from the goal towards the start, so
+// the start can move along the path and edits of the grid, reported
+// with cellChanged, only invalidate the costs to the goal they change.
+// The next plan repairs those and leaves the rest of the search tree
+// alone, a replan costs about as much as the change instead of the map.
+class DStarLite {
+public:
+    DStarLite(const WeightedGrid& grid, Coordinates start, Coordinates goal, const SearchOptions& options = {});
+
+    Coordinates start() const { return this->mStart; }
+    Coordinates goal() const { return this->mGoal; }
+    // The agent moved, e.g. along the last path
+    void setStart(Coordinates start);
+    // Costs to a new goal have nothing in common with the old ones, this
+    // drops all state
+    void setGoal(Coordinates goal);
+    // Call after the obstacle or the weight of id changed in grid
+    void cellChanged(const WeightedGrid& grid, Coordinates id);
+
+    // Repairs the costs to the goal as far as the start needs them and
+    // walks down to the goal. Expanded counts the cells this plan touched.
+    SearchResult plan(const WeightedGrid& grid, SearchTrace* trace = nullptr);
+
+private:
+    using Key = std::pair<Cost, Cost>;
+    static constexpr Cost INFINITE = ~Cost(0);
+
+    SearchOptions options;
+    int mWidth, mHeight;
+    Coordinates mStart, mGoal;
+    Coordinates last;   // Start when km was last brought up to date
+    Cost km = 0;        // Heuristic distance the start has moved
+    // g: cost to the goal as of the last expansion, rhs: the one step
+    // lookahead of it. Both are infinite unless the stamp is current.
+    std::vector<Cost> g, rhs;
+    std::vector<std::uint32_t> stamp;
+    std::uint32_t generation = 0;
+    BasicIndexedHeap<Key> open;
+
+    bool inBounds(Coordinates id) const {
+        return 0 <= id.x && id.x < this->mWidth && 0 <= id.y && id.y < this->mHeight;
+    }
+    int index(Coordinates id) const { return id.y * this->mWidth + id.x; }
+    Coordinates coordinates(int cell) const { return Coordinates{cell % this->mWidth, cell / this->mWidth}; }
+    void touch(int cell) {
+        if (this->stamp[cell] == this->generation) return;
+        this->stamp[cell] = this->generation;
+        this->g[cell] = this->rhs[cell] = INFINITE;
+    }
+    Key key(int cell) const;
+    // Queued exactly while g and rhs differ, true if it is
+    bool update(int cell);
+    // Smallest cost to the goal over the steps out of a cell
+    Cost lookahead(const WeightedGrid& grid, int cell) const;
+    // Calls visit(previousCell, stepCost) for every cell with a step to cell
+    template <class Visit>
+    void forEachPredecessor(const WeightedGrid& grid, int cell, Visit&& visit) const;
+};
+
+#endif // DSTAR_H
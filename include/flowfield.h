@@ -0,0 +1,77 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include "grid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Costs from every cell to one goal and the first step of a shortest
+// path from each, so any number of agents heading for the same goal
+// read their next step instead of searching. Steps out of a cell inside
+// an obstacle count, like in the searches.
+//
+// Built by a Dijkstra backwards from the goal that is cut into square
+// tiles. Tiles run on all threads in rounds, each one a Dijkstra seeded
+// with the costs on its border. A cost lowered across the border, taken
+// as an atomic minimum, wakes the tile it belongs to for the next round,
+// until no tile has anything left to lower.
+//
+// A cell takes three bytes: its cost to the goal in 16 bits, in units
+// of unit() rounded down, and the direction of its step. Read only
+// once built, so threads can share a field.
+class FlowField {
+public:
+    static constexpr std::uint16_t UNREACHED = 0xffff;
+    // Direction of the goal and of cells that cannot reach it
+    static constexpr std::uint8_t NONE = 0xff;
+
+    // Builds on threads threads, 0 uses all cores
+    FlowField(const WeightedGrid& grid, Coordinates goal, const SearchOptions& options = {},
+              unsigned threads = 0, int tileSize = 64);
+
+    Coordinates goal() const { return this->mGoal; }
+    int width() const { return this->mWidth; }
+    int height() const { return this->mHeight; }
+    // Cells taken off the frontiers while building, more than a single
+    // Dijkstra would since tiles may settle a cell more than once
+    std::size_t expanded() const { return this->mExpanded; }
+    // Frontier counters of all tiles and the build time as searchUs,
+    // zero without PATHSEARCH_STATS
+    const SearchStats& stats() const { return this->mStats; }
+
+    // Index of Grid::DELTA to step in
+    std::uint8_t direction(int cell) const { return this->directions[cell]; }
+    bool reachable(int cell) const { return this->costs[cell] != UNREACHED; }
+    // Next cell on a shortest path to the goal, id itself at the goal or
+    // where there is none
+    Coordinates next(Coordinates id) const {
+        std::uint8_t direction = this->directions[id.y * this->mWidth + id.x];
+        if (direction == NONE) return id;
+        return Coordinates{id.x + Grid::DELTA[direction].x, id.y + Grid::DELTA[direction].y};
+    }
+    // Cost to the goal rounded down to a multiple of unit(), ~0 if unreached
+    Cost distance(int cell) const {
+        return this->costs[cell] == UNREACHED ? ~Cost(0) : this->costs[cell] * this->mUnit;
+    }
+    Cost unit() const { return this->mUnit; }
+    const std::uint16_t* distanceData() const { return this->costs.data(); }
+    const std::uint8_t* directionData() const { return this->directions.data(); }
+
+    // Follows the directions from start. Expands nothing, the cost is
+    // exact. Only valid on the grid the field was built on; the path is
+    // empty if following the directions does not reach the goal.
+    SearchResult path(const WeightedGrid& grid, Coordinates start, SearchTrace* trace = nullptr) const;
+
+private:
+    int mWidth, mHeight;
+    Coordinates mGoal;
+    Cost mUnit = 1;
+    std::size_t mExpanded = 0;
+    SearchStats mStats;
+    std::vector<std::uint16_t> costs;
+    std::vector<std::uint8_t> directions;
+};
+
+#endif // FLOWFIELD_H
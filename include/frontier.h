@@ -0,0 +1,127 @@
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+#include "helper.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Frontiers for Dijkstra and A* besides the binary PrioriyQueue. All of
+// them take int items with Cost priorities and share one interface:
+// reset(items) before a search, put(item, priority), and
+// get(priority) which removes a minimum item and reports its priority.
+// The bucket queue and the radix heap keep stale duplicates like
+// PrioriyQueue and need monotone priorities: nothing put may be smaller
+// than the last priority taken out. The indexed heap updates items in
+// place and accepts any priorities.
+
+// Dial's bucket queue: a ring of buckets, one per priority, wide enough
+// for the spread between the smallest and the largest queued priority.
+// An occupancy bitmap skips runs of 64 empty buckets at once. Best for
+// small integer costs, the ring grows when the spread exceeds it, up to
+// MAX_BUCKETS. Priorities beyond that wait in a binary heap until the
+// ring runs empty, so heavy terrain weights or long jumps cost memory
+// for no more than MAX_BUCKETS buckets. reset() shrinks a ring the last
+// SHRINK_AFTER queries used less than a quarter of.
+class BucketQueue {
+public:
+    static constexpr std::size_t MIN_BUCKETS = 1024;
+    static constexpr std::size_t MAX_BUCKETS = std::size_t(1) << 16;
+    static constexpr unsigned SHRINK_AFTER = 64;
+
+    void reset(std::size_t items);
+    bool empty() const { return this->count == 0 && this->far.empty(); }
+    void put(int item, Cost priority);
+    int get(Cost& priority);
+
+private:
+    std::vector<std::vector<int>> buckets; // Size is a power of two
+    std::vector<std::uint64_t> occupied;
+    Cost base = 0;                         // No priority in the ring is smaller
+    std::size_t count = 0;                 // In the ring
+    Cost widest = 0;                       // Largest spread since reset
+    unsigned oversized = 0;                // Resets in a row the ring was too large at
+    // Min-heap of the priorities from limit on, above all in the ring
+    std::vector<std::pair<Cost, int>> far;
+    Cost limit = ~Cost(0);
+
+    std::size_t mask() const { return this->buckets.size() - 1; }
+    void insert(int item, Cost priority) {
+        std::size_t i = priority & mask();
+        this->buckets[i].push_back(item);
+        this->occupied[i / 64] |= std::uint64_t(1) << (i % 64);
+        ++this->count;
+    }
+    void rebuild(int item, Cost priority); // Rehash so that priority fits as well, or overflows
+    void refill();                         // Ring empty, the lowest far priorities move in
+};
+
+// Radix heap: bucket i holds priorities that first differ from the last
+// one taken out in bit i-1. Every item moves to lower buckets at most 64
+// times, so wide fixed point costs are as cheap as small ones.
+class RadixHeap {
+public:
+    void reset(std::size_t items);
+    bool empty() const { return this->count == 0; }
+    void put(int item, Cost priority);
+    int get(Cost& priority);
+
+private:
+    std::array<std::vector<std::pair<Cost, int>>, 65> buckets;
+    Cost last = 0;
+    std::size_t count = 0;
+
+    int bucket(Cost priority) const {
+        return priority == this->last ? 0 : 64 - __builtin_clzll(priority ^ this->last);
+    }
+};
+
+// 4-ary min-heap with a position per item, so put lowers (or raises) the
+// priority of a queued item instead of adding a duplicate. Positions are
+// reset in O(1) with a generation stamp like SearchSpace. Instantiated
+// for Cost and for the two part keys of D* Lite.
+template <class Priority>
+class BasicIndexedHeap {
+public:
+    void reset(std::size_t items);
+    bool empty() const { return this->heap.empty(); }
+    bool contains(int item) const {
+        return this->stamp[item] == this->generation && this->position[item] >= 0;
+    }
+    Priority priority(int item) const { return this->heap[this->position[item]].first; }
+    const std::pair<Priority, int>& top() const { return this->heap.front(); }
+    void put(int item, Priority priority);
+    int get(Priority& priority);
+    void remove(int item);
+    // Gives every queued item the priority of priority(item), restoring
+    // the heap in linear time
+    template <class Reprioritize>
+    void reprioritize(Reprioritize&& priority) {
+        if (this->heap.empty()) return;
+        for (auto& entry : this->heap)
+            entry.first = priority(entry.second);
+        for (std::size_t i = (this->heap.size() - 1) / ARITY + 1; i-- > 0;)
+            siftDown(i);
+    }
+
+private:
+    static constexpr std::size_t ARITY = 4;
+    std::vector<std::pair<Priority, int>> heap;
+    std::vector<int> position;
+    std::vector<std::uint32_t> stamp;
+    std::uint32_t generation = 0;
+
+    void place(std::size_t i, std::pair<Priority, int> entry) {
+        this->heap[i] = entry;
+        this->position[entry.second] = static_cast<int>(i);
+    }
+    void siftUp(std::size_t i);
+    void siftDown(std::size_t i);
+};
+
+using IndexedHeap = BasicIndexedHeap<Cost>;
+
+#endif // FRONTIER_H
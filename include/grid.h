@@ -1,45 +1,540 @@
 #ifndef GRID_H
 #define GRID_H
 
+#include "frontier.h"
 #include "helper.h"
-#include "visualizer.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+enum class Algorithm {
+    breadthFirst, dijkstra, astar, jps, wavefront, hpa, dstarLite, alt, flowField, pathDatabase, anytime
+};
+
+// Short names used on the command line: "bfs", "dijkstra", "astar", "jps", "wavefront", "hpa",
+// "dstar", "alt", "flow", "cpd", "ara"
+const char* algorithmName(Algorithm algorithm);
+bool parseAlgorithm(const std::string& name, Algorithm& algorithm);
+
+// Priority queues for Dijkstra and A*, see frontier.h
+enum class Frontier { binaryHeap, bucketQueue, radixHeap, indexedHeap };
+
+// Short names used on the command line: "binary", "bucket", "radix", "indexed"
+const char* frontierName(Frontier frontier);
+bool parseFrontier(const std::string& name, Frontier& frontier);
+
+enum class Connectivity { four, eight };
+
+// When a diagonal step may pass the corner of an obstacle: always, if
+// one of the two cells it passes between is open, or never
+enum class CornerCutting { always, oneOpen, never };
+
+// Short names used on the command line: "always", "one-open", "never"
+const char* cornerCuttingName(CornerCutting corners);
+bool parseCornerCutting(const std::string& name, CornerCutting& corners);
+
+// Bounds on a single query, for latency budgets and for stopping a
+// search from another thread. BFS, Dijkstra, A*, JPS, ALT and ARA*, one
+// way or bidirectional, look at the expansions before each one and at
+// the flag and the clock every few hundred. The other algorithms run to
+// the end.
+struct SearchLimits {
+    const std::atomic<bool>* cancel = nullptr; // Stops once another thread sets it
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    // From the start of each query, so one set of options fits a batch
+    std::chrono::steady_clock::duration budget = std::chrono::steady_clock::duration::max();
+    std::size_t maxExpanded = SIZE_MAX;
+};
+
+// Knobs of a single query. The frontier changes how it runs but not its
+// answer. JPS, the wavefront BFS and HPA* always move in four directions.
+// Bidirectional BFS, Dijkstra and A* search from both ends until the
+// halves meet, for paths as short as the one way ones.
+struct SearchOptions {
+    Frontier frontier = Frontier::bucketQueue;
+    Connectivity connectivity = Connectivity::four;
+    CornerCutting cornerCutting = CornerCutting::never;
+    bool bidirectional = false;
+    SearchLimits limits;
+    // Heuristic weight of the first ARA* round
+    double anytimeWeight = 3;
+};
+
+// Costs are kept in fixed point, one straight step costs COST_SCALE and
+// a diagonal one sqrt(2) of that, rounded down
+constexpr Cost COST_SCALE = 1000;
+constexpr Cost DIAGONAL_COST = 1414;
+
+// Step in direction (an index of Grid::DELTA) before terrain weights.
+// Straight steps from cells of even x + y cost a little more going east
+// or west, from odd ones going north or south. Nudges ties towards
+// "prettier" staircase paths in Dijkstra and A*.
+inline Cost stepCost(Coordinates from, int direction) {
+    if (direction >= 4) return DIAGONAL_COST;
+    return COST_SCALE + Cost(unsigned((from.x + from.y) & 1) == unsigned(direction >> 1));
+}
+
+// Estimated cost between two cells: Manhattan distance with four
+// directions, octile distance with eight. Neither overestimates a step
+// onto the cheapest terrain, weight 1, so both are consistent.
+inline Cost heuristic(Coordinates a, Coordinates b, Connectivity connectivity) {
+    Cost dx = std::abs(b.x - a.x), dy = std::abs(b.y - a.y);
+    if (connectivity == Connectivity::four) return (dx + dy) * COST_SCALE;
+    return std::max(dx, dy) * COST_SCALE + std::min(dx, dy) * (DIAGONAL_COST - COST_SCALE);
+}
+
+// Built with PATHSEARCH_STATS (the CMake option of the same name) the
+// searches count what their frontiers do and time their phases. Without
+// it the counters stay zero and the counting compiles away.
+#ifndef PATHSEARCH_STATS
+#define PATHSEARCH_STATS 0
+#endif
+constexpr bool SEARCH_STATS = PATHSEARCH_STATS;
+
+// What a single query did besides expanding nodes
+struct SearchStats {
+    std::size_t pushes = 0;        // Frontier insertions, duplicates included
+    std::size_t stalePops = 0;     // Outdated duplicates taken off and skipped
+    std::size_t relaxations = 0;   // Cells whose cost dropped
+    std::size_t reRelaxations = 0; // Of those, cells that already had a cost
+    // Wall time in microseconds of clearing the scratch arrays, of the
+    // search loop and of walking the path back
+    double setupUs = 0;
+    double searchUs = 0;
+    double pathUs = 0;
+};
+
+// Splits the wall time of a query into phases. Reads no clock without
+// PATHSEARCH_STATS.
+class PhaseTimer {
+public:
+    PhaseTimer() {
+        if constexpr (SEARCH_STATS) this->last = std::chrono::steady_clock::now();
+    }
+    // Adds the time since the last lap to phase
+    void lap(double& phase) {
+        if constexpr (SEARCH_STATS) {
+            auto now = std::chrono::steady_clock::now();
+            phase += std::chrono::duration<double, std::micro>(now - this->last).count();
+            this->last = now;
+        }
+    }
+
+private:
+    std::chrono::steady_clock::time_point last;
+};
+
+// Outcome of a single query. A search stopped by its SearchLimits is
+// partial: its path leads from the start to the expanded cell closest to
+// the goal, or to the goal on a path that need not be the shortest, and
+// cost is that of the path.
+struct SearchResult {
+    std::vector<Coordinates> path; // Start to goal, empty if the goal is unreachable
+    double cost = 0;
+    std::size_t expanded = 0;      // Nodes taken off the frontier
+    bool partial = false;
+    double suboptimality = 1;      // ARA*: cost is at most this times the shortest
+    SearchStats stats;             // Zero without PATHSEARCH_STATS
+
+    bool found() const { return !path.empty() && !partial; }
+};
+
+// Visited and path cells of one search in the order they happened, so a
+// viewer can replay a search that already ran at full speed. Searches
+// clear the trace first and reuse its capacity.
+class SearchTrace {
+public:
+    enum class Kind : std::uint8_t { visited, path };
+    struct Event {
+        std::int32_t cell;
+        Kind kind;
+    };
+
+    void reserve(std::size_t events) { this->mEvents.reserve(events); }
+    void clear() { this->mEvents.clear(); }
+    void visit(int cell) { this->mEvents.push_back(Event{cell, Kind::visited}); }
+    void path(int cell) { this->mEvents.push_back(Event{cell, Kind::path}); }
+    const std::vector<Event>& events() const { return this->mEvents; }
+
+private:
+    std::vector<Event> mEvents;
+};
+
+// Per-query scratch arrays indexed like the grid cells. A query only
+// bumps the generation, a cell is reached if its stamp matches it.
+// Concurrent searches need one space per thread.
+class SearchSpace {
+public:
+    void reset(std::size_t cells);
+
+    bool reached(int cell) const { return this->stamp[cell] == this->generation; }
+    void reach(int cell, int parent, Cost cost = 0) {
+        this->stamp[cell] = this->generation;
+        this->parents[cell] = parent;
+        this->costs[cell] = cost;
+    }
+    int parent(int cell) const { return this->parents[cell]; }
+    Cost cost(int cell) const { return this->costs[cell]; }
+
+    // Reused frontiers
+    std::vector<int> queue;
+    PrioriyQueue<int, Cost> heap;
+    BucketQueue buckets;
+    RadixHeap radix;
+    IndexedHeap indexed;
+    // Wavefront BFS: bit sets in the bitmap layout, padded so a block can
+    // read a row above and below, and the 4 word blocks they are worked
+    // on in. All zero between queries.
+    struct Wavefront {
+        std::vector<std::uint64_t> frontier, next, visited;
+        std::vector<std::uint32_t> active, candidates;
+        std::vector<std::uint8_t> marked;
+    } wave;
+    // One layer per cell. A query numbers its layers above every value
+    // left by earlier ones, so they need no clearing either.
+    void resetLayers(std::size_t cells);
+    bool layerReached(int cell) const { return this->layers[cell] >= this->layerBase; }
+    std::uint32_t layer(int cell) const { return this->layers[cell] - this->layerBase; }
+    void setLayer(int cell, std::uint32_t layer) { this->layers[cell] = this->layerBase + layer; }
+    // Space of the search from the goal in bidirectional searches
+    SearchSpace& backward();
+
+private:
+    std::vector<std::uint32_t> stamp;
+    std::vector<int> parents;
+    std::vector<Cost> costs;
+    std::uint32_t generation = 0;
+    std::vector<std::uint32_t> layers;
+    std::uint32_t layerBase = 0;
+    std::vector<SearchSpace> mBackward; // Empty until the first bidirectional search
+};
+
+class Components;
+class JumpTable;
+class Hierarchy;
+class Landmarks;
+class PathDatabase;
 
 class Grid {
 public:
-    Grid();
+    // Cells are indexed with int, so the size must pass validSize()
+    Grid(int width, int height);
+    // View a bitmap in the layout described below, e.g. a mapped file
+    Grid(int width, int height, std::shared_ptr<std::uint64_t> bitmap);
+
+    // Sides of at least one cell whose cells, indices and bitmap rows
+    // fit into int. Loaders reject maps of other sizes.
+    static bool validSize(long long width, long long height) {
+        return width > 0 && height > 0 && width <= INT_MAX - 128 && height <= INT_MAX - 128
+            && width * height <= INT_MAX;
+    }
+
+    // Bitmap layout
+    static int rowWords(int width) { return (width + 2 + 63) / 64; }
+    static std::size_t bitmapWords(int width, int height) {
+        return std::size_t(height + 2) * rowWords(width);
+    }
+    const std::uint64_t* bitmap() const { return this->bits.get(); }
 
-    // Container
-    static std::array<Coordinates, 4> DELTA;
-    std::unordered_set<Coordinates> obstacles;
-    std::unordered_map<Coordinates, Coordinates> cameFrom;
+    // Changes with every edit of the obstacles or weights and never
+    // comes back, so equal versions mean equal maps. Copies keep the
+    // version until one of them is edited.
+    std::uint64_t version() const { return this->mVersion; }
+
+    // Container: east, west, north, south, then the diagonals
+    static std::array<Coordinates, 8> DELTA;
 
     // Getter
+    int width() const { return this->mWidth; }
+    int height() const { return this->mHeight; }
+    int cellCount() const { return this->mWidth * this->mHeight; }
+    int index(Coordinates id) const { return id.y * this->mWidth + id.x; }
+    Coordinates coordinates(int cell) const {
+        return Coordinates{cell % this->mWidth, cell / this->mWidth};
+    }
     bool inBounds(Coordinates id) const;
     bool passable(Coordinates id) const;
     std::vector<Coordinates> neighbors(Coordinates id) const;
 
-    // Methods
-    void initGrid(QVector<QVector<Tile*>> tiles);
-    void printPath();
+    // Open neighbors as a mask, bit d set if DELTA[d] is passable
+    unsigned neighborMask(Coordinates id) const {
+        const std::uint64_t* words = this->bits.get();
+        // Bits j-1, j and j+1 of the bitmap, usually from a single word
+        auto window = [words](std::size_t j) {
+            unsigned shift = j % 64;
+            if (shift - 1 < 62) return unsigned(words[j / 64] >> (shift - 1)) & 7;
+            return (unsigned(words[(j - 1) / 64] >> ((j - 1) % 64)) & 1)
+                 | (unsigned(words[j / 64] >> shift) & 1) << 1
+                 | (unsigned(words[(j + 1) / 64] >> ((j + 1) % 64)) & 1) << 2;
+        };
+        std::size_t i = bitIndex(id), row = std::size_t(this->stride) * 64;
+        unsigned north = window(i - row), middle = window(i), south = window(i + row);
+        return (middle >> 2 & 1) | (middle & 1) << 1 | (north >> 1 & 1) << 2 | (south >> 1 & 1) << 3
+             | (north >> 2 & 1) << 4 | (north & 1) << 5 | (south >> 2 & 1) << 6 | (south & 1) << 7;
+    }
+
+    // Calls visit(next, nextCell, direction) for every open neighbor in
+    // the same order as neighbors(), without allocating
+    template <class Visit>
+    void forEachNeighbor(Coordinates id, Visit&& visit) const {
+        forEachNeighbor(id, Connectivity::four, CornerCutting::never, visit);
+    }
+    // Diagonal neighbors come after the straight ones
+    template <class Visit>
+    void forEachNeighbor(Coordinates id, Connectivity connectivity, CornerCutting corners,
+                         Visit&& visit) const {
+        unsigned open = neighborMask(id);
+        int cell = index(id), w = this->mWidth;
+        const int offset[8] = {1, -1, -w, w, 1 - w, -1 - w, 1 + w, -1 + w};
+        // Nudge directions for "prettier" paths
+        bool reverse = (id.x + id.y) % 2 == 0;
+        for (int k = 0; k < 4; ++k) {
+            int direction = reverse ? 3 - k : k;
+            if (open >> direction & 1)
+                visit(Coordinates{id.x + DELTA[direction].x, id.y + DELTA[direction].y},
+                      cell + offset[direction], direction);
+        }
+        if (connectivity == Connectivity::four) return;
+        for (int direction = 4; direction < 8; ++direction) {
+            if (!(open >> direction & 1)) continue;
+            // The two straight neighbors the step passes between
+            unsigned horizontal = open >> (DELTA[direction].x > 0 ? 0 : 1) & 1;
+            unsigned vertical = open >> (DELTA[direction].y < 0 ? 2 : 3) & 1;
+            if (corners == CornerCutting::never && !(horizontal && vertical)) continue;
+            if (corners == CornerCutting::oneOpen && !(horizontal || vertical)) continue;
+            visit(Coordinates{id.x + DELTA[direction].x, id.y + DELTA[direction].y},
+                  cell + offset[direction], direction);
+        }
+    }
+
+    // Jump point search reads the jumps from a table instead of scanning
+    // for them. Edits drop the table until it is computed again.
+    void precomputeJumps();
+    bool hasJumpTable() const { return this->jumps != nullptr; }
+
+    // Search algorithm. The overloads taking a SearchSpace leave the grid
+    // untouched, so threads can share one grid with a space each.
+    // Counts steps, diagonal ones included
+    SearchResult breadthFirstSearch(Coordinates start, Coordinates goal,
+                                    SearchTrace* trace = nullptr, const SearchOptions& options = {}) {
+        return breadthFirstSearch(this->space, start, goal, trace, options);
+    }
+    SearchResult breadthFirstSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                    SearchTrace* trace = nullptr, const SearchOptions& options = {}) const;
+    // BFS expanding a whole layer at once with word wide (AVX2 where the
+    // CPU has it) bit operations on the bitmap. Same path lengths as
+    // breadthFirstSearch, ties may break differently.
+    SearchResult wavefrontSearch(Coordinates start, Coordinates goal,
+                                 SearchTrace* trace = nullptr) {
+        return wavefrontSearch(this->space, start, goal, trace);
+    }
+    SearchResult wavefrontSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                 SearchTrace* trace = nullptr) const;
+    // Steps from source to every cell, -1 where it is unreachable
+    std::vector<int> distanceField(Coordinates source) const;
+    // Whether the wavefront runs its AVX2 kernel, by default where the
+    // CPU has it. Off it runs the scalar one, e.g. to compare the two.
+    // Process wide, not to be switched while a wavefront runs.
+    static bool wavefrontSimd();
+    static void setWavefrontSimd(bool enabled);
+
+protected:
+    // Edits go through WeightedGrid, which keeps what it built on top
+    // of the bitmap up to date
+    void setObstacle(Coordinates id, bool obstacle = true);
+
+    int mWidth, mHeight;
+    std::uint64_t mVersion;
+
+    // Passability bitmap with a one cell border of obstacles, so
+    // neighbors at the map edge need no bounds check. Row y of the map
+    // is row y+1 of the bitmap, column x is bit x+1. Copies of a grid
+    // share the bitmap until one of them is edited.
+    int stride;                      // 64 bit words per bitmap row
+    std::shared_ptr<std::uint64_t> bits;
+    std::size_t bitIndex(Coordinates id) const {
+        return std::size_t(id.y + 1) * this->stride * 64 + std::size_t(id.x + 1);
+    }
+
+    std::shared_ptr<const JumpTable> jumps;
 
-    // Search algorithm
-    void breadthFirstSearch();
+    SearchSpace space;
+    // Layers from source until the one holding goal, or all of them if
+    // goal is -1, into the layers of space. Returns the cells reached.
+    std::size_t wavefront(SearchSpace& space, int source, int goal, SearchTrace* trace) const;
+    std::vector<Coordinates> reconstructPath(const SearchSpace& space, int start, int goal) const;
+    // Partial result of a search stopped by its limits, the path to cell
+    void stopAt(SearchResult& result, const SearchSpace& space, int start, int cell, SearchTrace* trace) const;
+    // Start ... meet from the forward space, then meet ... goal from the backward one
+    std::vector<Coordinates> joinPaths(SearchSpace& space, int start, int meet, int goal) const;
+    SearchResult bidirectionalBreadthFirst(SearchSpace& space, Coordinates start, Coordinates goal,
+                                           SearchTrace* trace, const SearchOptions& options) const;
+    void beginTrace(SearchTrace& trace) const;
+    void endTrace(SearchTrace& trace, const std::vector<Coordinates>& path) const;
 };
 
 class WeightedGrid : public  Grid {
 public:
-    std::unordered_map<Coordinates, double> costSoFar;
-    double cost(Coordinates fromNode, Coordinates toNode) const;
-    void clearContainers() {
-        this->obstacles.clear();
-        this->cameFrom.clear();
-        this->costSoFar.clear();
-    }
+    using Grid::Grid;
+
+    // Terrain: stepping onto a cell costs its weight times the straight
+    // or diagonal step cost. Weights are at least 1 and kept row major,
+    // one per cell, in 8 bits until a weight needs 16. A grid without
+    // any costs 1 everywhere. Copies share the weights until one of
+    // them is edited. BFS, JPS and the wavefront BFS ignore them.
+    void setWeight(Coordinates id, unsigned weight);
+    unsigned weight(Coordinates id) const;
+    bool hasWeights() const { return this->weights8 || this->weights16; }
+    // 0 without weights, else 1 or 2
+    int weightBytes() const { return this->weights16 ? 2 : this->weights8 ? 1 : 0; }
+    const void* weightData() const;
+    // View weights laid out as above, e.g. in a mapped file. Rebuilds
+    // the hierarchy below if there is one.
+    void setWeights(std::shared_ptr<std::uint8_t> weights);
+    void setWeights(std::shared_ptr<std::uint16_t> weights);
+
+    // Edits keep the hierarchy below up to date
+    void setObstacle(Coordinates id, bool obstacle = true);
+
+    // HPA* searches a graph of cluster entrances, see hpa.h. Edits only
+    // redo the clusters around the edited cell. Builds on all cores if
+    // threads is 0.
+    void buildHierarchy(int clusterSize = 32, unsigned threads = 0);
+    bool hasHierarchy() const { return this->hierarchy != nullptr; }
+
+    // Connected components of the open cells, see components.h. Once
+    // built, search() answers a query whose goal is outside the
+    // component of its start without searching. Edits keep them up to
+    // date.
+    void buildComponents(const SearchOptions& options = {});
+    const Components* components() const { return this->mComponents.get(); }
+
+    // ALT searches A* with the landmark lower bounds of landmarks.h,
+    // valid for the steps of options. Edits drop them until they are
+    // built or set again.
+    void buildLandmarks(int count = 8, const SearchOptions& options = {});
+    void setLandmarks(std::shared_ptr<const Landmarks> landmarks);
+    const Landmarks* landmarks() const { return this->mLandmarks.get(); }
+
+    // The compressed path database of pathdatabase.h answers queries to
+    // its targets without searching, under the steps of options. Edits
+    // drop it until it is built or set again.
+    void buildPathDatabase(const std::vector<Coordinates>& targets, const SearchOptions& options = {},
+                           unsigned threads = 0);
+    void setPathDatabase(std::shared_ptr<const PathDatabase> database);
+    const PathDatabase* pathDatabase() const { return this->mPathDatabase.get(); }
+
+    Cost cost(Coordinates fromNode, Coordinates toNode) const;
 
     // Search algorithms
-    void dijkstraSearch();
-    void aStarSearch();
+    SearchResult dijkstraSearch(Coordinates start, Coordinates goal,
+                                SearchTrace* trace = nullptr, const SearchOptions& options = {}) {
+        return dijkstraSearch(this->space, start, goal, trace, options);
+    }
+    SearchResult dijkstraSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                SearchTrace* trace = nullptr, const SearchOptions& options = {}) const;
+    SearchResult aStarSearch(Coordinates start, Coordinates goal,
+                             SearchTrace* trace = nullptr, const SearchOptions& options = {}) {
+        return aStarSearch(this->space, start, goal, trace, options);
+    }
+    SearchResult aStarSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                             SearchTrace* trace = nullptr, const SearchOptions& options = {}) const;
+    // Uniform step costs, neither the nudge of cost() nor the weights apply
+    SearchResult jumpPointSearch(Coordinates start, Coordinates goal,
+                                 SearchTrace* trace = nullptr, const SearchOptions& options = {}) {
+        return jumpPointSearch(this->space, start, goal, trace, options);
+    }
+    SearchResult jumpPointSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                 SearchTrace* trace = nullptr, const SearchOptions& options = {}) const;
+    // A* until buildHierarchy has been called
+    SearchResult hierarchicalSearch(Coordinates start, Coordinates goal, SearchTrace* trace = nullptr) {
+        return hierarchicalSearch(this->space, start, goal, trace);
+    }
+    SearchResult hierarchicalSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                    SearchTrace* trace = nullptr) const;
+    // A* unless there are landmarks for the steps of options. Always one way.
+    SearchResult altSearch(Coordinates start, Coordinates goal,
+                           SearchTrace* trace = nullptr, const SearchOptions& options = {}) {
+        return altSearch(this->space, start, goal, trace, options);
+    }
+    SearchResult altSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                           SearchTrace* trace = nullptr, const SearchOptions& options = {}) const;
+    // A* unless the path database covers the goal, a start outside
+    // obstacles and the steps of options. Always one way.
+    SearchResult databaseSearch(Coordinates start, Coordinates goal,
+                                SearchTrace* trace = nullptr, const SearchOptions& options = {}) {
+        return databaseSearch(this->space, start, goal, trace, options);
+    }
+    SearchResult databaseSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                SearchTrace* trace = nullptr, const SearchOptions& options = {}) const;
+    // ARA*: weighted A* rounds with a falling weight, each one improving
+    // the path of the last, until the weight is 1 and the path shortest
+    // or the limits of options stop it. Always one way.
+    SearchResult anytimeSearch(Coordinates start, Coordinates goal,
+                               SearchTrace* trace = nullptr, const SearchOptions& options = {}) {
+        return anytimeSearch(this->space, start, goal, trace, options);
+    }
+    SearchResult anytimeSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                               SearchTrace* trace = nullptr, const SearchOptions& options = {}) const;
+    // With PATHSEARCH_STATS every query also goes into the process wide
+    // searchStatistics() of statistics.h
+    SearchResult search(Algorithm algorithm, Coordinates start, Coordinates goal,
+                        SearchTrace* trace = nullptr, const SearchOptions& options = {}) {
+        return search(this->space, algorithm, start, goal, trace, options);
+    }
+    SearchResult search(SearchSpace& space, Algorithm algorithm, Coordinates start, Coordinates goal,
+                        SearchTrace* trace = nullptr, const SearchOptions& options = {}) const;
+
+private:
+    SearchResult dispatch(SearchSpace& space, Algorithm algorithm, Coordinates start, Coordinates goal,
+                          SearchTrace* trace, const SearchOptions& options) const;
+    std::shared_ptr<std::uint8_t> weights8;
+    std::shared_ptr<std::uint16_t> weights16;
+    // Shared by copies until one of them is edited
+    std::shared_ptr<Hierarchy> hierarchy;
+    void updateHierarchy(Coordinates id);
+    // After setWeights replaced all of them
+    void weightsChanged();
+    std::shared_ptr<const Landmarks> mLandmarks;
+    std::shared_ptr<const PathDatabase> mPathDatabase;
+    // Shared by copies until one of them is edited
+    std::shared_ptr<Components> mComponents;
+
+    // Calls search(stepCost) with the step cost policy of the weights,
+    // so each search loop is compiled for one weight type
+    template <class Search>
+    SearchResult withStepCost(Search&& search) const;
+
+    // Dijkstra, A* and JPS differ in the heuristic and in how a node is
+    // expanded: expand(cell, id, relax) calls relax(next, stepCost) per successor
+    template <class Queue, class Heuristic, class Expand>
+    SearchResult bestFirst(SearchSpace& space, Queue& frontier, Heuristic heuristic, Expand expand,
+                           Coordinates start, Coordinates goal, SearchTrace* trace,
+                           const SearchOptions& options) const;
+    template <class Heuristic, class Expand>
+    SearchResult bestFirst(SearchSpace& space, Heuristic heuristic, Expand expand, Coordinates start,
+                           Coordinates goal, SearchTrace* trace, const SearchOptions& options) const;
+    // Dijkstra and A* from both ends, estimate(a, b) bounds the cost from a to b
+    template <class Queue, class Estimate, class StepCost>
+    SearchResult bidirectional(SearchSpace& space, Queue& forward, Queue& backward, Estimate estimate,
+                               StepCost stepCost, Coordinates start, Coordinates goal, SearchTrace* trace,
+                               const SearchOptions& options) const;
+    template <class Estimate, class StepCost>
+    SearchResult bidirectional(SearchSpace& space, Estimate estimate, StepCost stepCost, Coordinates start,
+                               Coordinates goal, SearchTrace* trace, const SearchOptions& options) const;
+    template <class StepCost>
+    SearchResult anytime(SearchSpace& space, StepCost stepCost, Coordinates start, Coordinates goal,
+                         SearchTrace* trace, const SearchOptions& options) const;
+    template <class StepCost, class Relax>
+    void expandNeighbors(Coordinates id, const SearchOptions& options, StepCost stepCost, Relax&& relax) const;
 };
 
 #endif // GRID_H
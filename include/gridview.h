@@ -0,0 +1,64 @@
+#ifndef GRIDVIEW_H
+#define GRIDVIEW_H
+
+#include <QImage>
+#include <QTimer>
+#include <QWidget>
+#include <initializer_list>
+#include <vector>
+
+#include "helper.h"
+
+enum class State : uchar { empty, obstacle, visited, start, goal, path };
+constexpr int STATE_COUNT = 6;
+
+// The whole map painted by one widget. setState only writes one byte,
+// the widget repaints at most once per frame no matter how many cells
+// changed. A repaint samples the cells into a QImage of the widget's
+// size, so its cost does not grow with the map.
+class GridView : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit GridView(QWidget *parent = nullptr);
+
+    void resizeMap(int width, int height);
+    int mapWidth() const { return this->mWidth; }
+    int mapHeight() const { return this->mHeight; }
+    bool inBounds(Coordinates id) const;
+
+    State state(Coordinates id) const { return this->cells[index(id)]; }
+    void setState(Coordinates id, State state);
+    // Empty every cell that is in one of the given states
+    void clearStates(std::initializer_list<State> states);
+
+    // Terrain weight below the state, empty cells heavier than 1 are
+    // painted as swamp
+    uchar weight(Coordinates id) const { return this->weights[index(id)]; }
+    void setWeight(Coordinates id, uchar weight);
+    void clearWeights();
+
+signals:
+    void cellClicked(Coordinates id);
+    void cellRightClicked(Coordinates id);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+
+private:
+    int mWidth = 0, mHeight = 0;
+    std::vector<State> cells;
+    std::vector<uchar> weights;
+    Coordinates start{-1, -1};
+    Coordinates goal{-1, -1};
+
+    QTimer frameTimer;
+    QImage frame;
+
+    std::size_t index(Coordinates id) const { return std::size_t(id.y) * this->mWidth + id.x; }
+    QRect mapRect() const;
+    void scheduleRepaint();
+};
+
+#endif // GRIDVIEW_H
@@ -1,32 +1,17 @@
 #ifndef HELPER_H
 #define HELPER_H
 
-#include <QPushButton>
-#include <QDebug>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <tuple>
 #include <queue>
-#include <unordered_map>
-#include <unordered_set>
+#include <vector>
 // #include <utility>
 
-enum class State { empty, obstacle, visited, start, goal, path };
-
-class Tile : public QPushButton {
-public:
-    // x = width, y = height
-    int x, y;
-    State state;
-
-    Tile(int x, int y, State state) : x(x), y(y), state(state) {}
-
-    // Getter
-    bool isEmpty() const { return this->state == State::empty; }
-    bool isObstacle() const { return this->state == State::obstacle; }
-    bool isVisited() const { return this->state == State::visited; }
-    bool isStart() const { return this->state == State::start; }
-    bool isGoal() const { return this->state == State::goal; }
-    bool isPath() const { return this->state == State::path; }
-};
+// Fixed point path cost, see COST_SCALE in grid.h
+using Cost = std::uint64_t;
 
 struct Coordinates {
     int x, y;
@@ -41,27 +26,27 @@ struct Coordinates {
     }
 };
 
-// "custom specialization of std::hash can be injected in namespace std"
-// Implement hash to put Coordinates into an unordered_set
-namespace std {
-template<>
-struct hash<Coordinates> {
-    std::size_t operator()(const Coordinates& id) const noexcept {
-        return std::hash<int>()(id.x ^ (id.y << 4));
-    }
-};
-} // namespace std
-
-// Wrapper for own priority queue sort
+// Wrapper for own priority queue sort, a binary min-heap on a vector
+// so the storage can be kept and reused across searches
 template<typename T, typename priority_t>
 struct PrioriyQueue {
-    std::priority_queue<std::pair<priority_t, T>, std::vector<std::pair<priority_t, T>>,
-        std::greater<std::pair<priority_t, T>>> elements;
+    std::vector<std::pair<priority_t, T>> elements;
     inline bool empty() const { return elements.empty(); }
-    inline void put(T item, priority_t priority) { elements.emplace(priority, item); }
+    inline void clear() { elements.clear(); }
+    inline void reset(std::size_t) { elements.clear(); } // Same interface as frontier.h
+    inline void put(T item, priority_t priority) {
+        elements.emplace_back(priority, item);
+        std::push_heap(elements.begin(), elements.end(), std::greater<std::pair<priority_t, T>>());
+    }
     T get() {
-        T ret = elements.top().second;
-        elements.pop();
+        priority_t priority;
+        return get(priority);
+    }
+    T get(priority_t& priority) {
+        std::pop_heap(elements.begin(), elements.end(), std::greater<std::pair<priority_t, T>>());
+        T ret = elements.back().second;
+        priority = elements.back().first;
+        elements.pop_back();
         return ret;
     }
 };
@@ -0,0 +1,81 @@
+#ifndef HPA_H
+#define HPA_H
+
+#include "grid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical path finding A* (HPA*) on the 4-connected grid. The map
+// is cut into square clusters. Wherever open cells face each other
+// across a cluster border, a transition joins an entrance cell on each
+// side, one in the middle of a short run and one at each end of a long
+// one. The costs between the entrances of a cluster are precomputed,
+// so a query searches the small graph of entrances and then refines
+// only the edges it took. Paths have to pass the transitions and may
+// be a few percent longer than the optimal ones. Terrain weights count.
+class Hierarchy {
+public:
+    // Cells in a cluster are numbered in an int, and every search in a
+    // cluster resets a space of a cluster's area
+    static constexpr int MAX_CLUSTER_SIZE = 1024;
+
+    // Clusters are built on threads threads, 0 uses all cores. The size
+    // is clamped to 1 ... MAX_CLUSTER_SIZE.
+    Hierarchy(const WeightedGrid& grid, int clusterSize, unsigned threads = 0);
+
+    int clusterSize() const { return this->size; }
+    std::size_t entranceCount() const;
+
+    // Redo the clusters touched by an edit of the obstacle or weight of id
+    void update(const WeightedGrid& grid, Coordinates id);
+
+    // Same result as the searches of WeightedGrid, except that it never
+    // steps out of a start inside an obstacle. The space is used for the
+    // entrance graph and for the searches inside single clusters.
+    SearchResult search(const WeightedGrid& grid, SearchSpace& space, Coordinates start, Coordinates goal,
+                        SearchTrace* trace) const;
+
+private:
+    static constexpr Cost NO_PATH = ~Cost(0);
+    // Runs of at least this many open cell pairs get two transitions
+    static constexpr int WIDE_ENTRANCE = 6;
+
+    struct Cluster {
+        std::vector<int> cells;          // Entrance cells, sorted
+        std::vector<std::uint8_t> exits; // Per entrance, bit d if a transition leads towards DELTA[d]
+        std::vector<Cost> distances;     // From row to column entrance, NO_PATH if there is none
+    };
+
+    int size, columns, rows;
+    int shift; // Cells in a cluster are numbered in rows of 1 << shift
+    std::vector<Cluster> clusters;
+    SearchSpace scratch; // For updates
+
+    int clusterOf(Coordinates id) const { return id.y / this->size * this->columns + id.x / this->size; }
+    int entrance(const Cluster& cluster, int cell) const;
+    void build(const WeightedGrid& grid, int cluster, SearchSpace& scratch);
+
+    // Dijkstra confined to one cluster until it has expanded every
+    // entrance, or A* if target is given, on local cell indices of
+    // space. Backward searches take the steps in reverse, so their costs
+    // are those of reaching source. Returns the nodes expanded.
+    template <bool Backward>
+    std::size_t explore(const WeightedGrid& grid, SearchSpace& space, int cluster, Coordinates source,
+                        Coordinates target, SearchTrace* trace) const;
+    template <bool Backward, class Weights>
+    std::size_t explore(const WeightedGrid& grid, SearchSpace& space, int cluster, Coordinates source,
+                        Coordinates target, SearchTrace* trace, Weights weights) const;
+    Coordinates origin(int cluster) const {
+        return Coordinates{cluster % this->columns * this->size, cluster / this->columns * this->size};
+    }
+    int local(Coordinates origin, Coordinates id) const {
+        return (id.y - origin.y) << this->shift | (id.x - origin.x);
+    }
+    Coordinates global(Coordinates origin, int local) const {
+        return Coordinates{origin.x + (local & ((1 << this->shift) - 1)), origin.y + (local >> this->shift)};
+    }
+};
+
+#endif // HPA_H
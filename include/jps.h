@@ -0,0 +1,40 @@
+#ifndef JPS_H
+#define JPS_H
+
+#include "grid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Jump Point Search on the 4-connected grid with uniform step costs.
+// Moving horizontally, a cell is a jump point if a cell above or below
+// it is open while the one diagonally behind is blocked. Moving
+// vertically, a cell is also a jump point if a horizontal jump from it
+// finds one. Directions index Grid::DELTA.
+
+// Scans from id in direction until a jump point or the goal and moves
+// id there. False if a wall comes first.
+bool jump(const Grid& grid, Coordinates& id, int direction, Coordinates goal);
+
+// JPS+: the jump of every cell in every direction, precomputed, so a
+// search reads one entry instead of scanning. Distances are clamped to
+// the int16 range by stopping at an extra jump point, which only adds
+// nodes to the search and keeps paths optimal.
+class JumpTable {
+public:
+    explicit JumpTable(const Grid& grid);
+
+    // > 0: jump point that many steps away, <= 0: open for -value steps, then a wall
+    int distance(int cell, int direction) const {
+        return this->jumps[std::size_t(cell) * 4 + direction];
+    }
+    // Same contract as the scan above. Vertical jumps also stop on the
+    // goal row, the horizontal jump from there decides if it is reached.
+    bool jump(const Grid& grid, Coordinates& id, int direction, Coordinates goal) const;
+
+private:
+    std::vector<std::int16_t> jumps;
+};
+
+#endif // JPS_H
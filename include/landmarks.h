@@ -0,0 +1,84 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include "grid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Landmark lower bounds for A* (ALT, Goldberg and Harrelson). A full
+// Dijkstra from and to each landmark gives, by the triangle inequality,
+// d(v, t) >= d(L, t) - d(L, v) and d(v, t) >= d(v, L) - d(t, L). On
+// mazes that is far tighter than the Manhattan distance, which only
+// sees the walls between v and t. Landmarks are picked farthest first
+// within the area connected to the middle of the map.
+//
+// Distances are kept in 16 bits per landmark, direction and cell, in
+// units of the landmark rounded down, all landmarks of a cell next to
+// each other. The bounds allow for the rounding and are scaled down a
+// little so they stay consistent: no step, at least COST_SCALE, lowers
+// them by more than it costs.
+class Landmarks {
+public:
+    // Unreached cells, in the table
+    static constexpr std::uint16_t UNREACHED = 0xffff;
+    // Each landmark adds 4 bytes per cell, and a bound reads all of them
+    static constexpr int MAX_COUNT = 64;
+
+    // Distances under the connectivity and corner cutting of options, for
+    // count clamped to MAX_COUNT
+    Landmarks(const WeightedGrid& grid, int count, const SearchOptions& options = {});
+    // View a table laid out as below, e.g. in a mapped file
+    Landmarks(int width, int height, const SearchOptions& options, std::vector<int> cells,
+              std::vector<std::uint32_t> units, std::shared_ptr<const std::uint16_t> table);
+
+    int width() const { return this->mWidth; }
+    int height() const { return this->mHeight; }
+    int count() const { return int(this->cells.size()); }
+    int cell(int landmark) const { return this->cells[landmark]; }
+    std::uint32_t unit(int landmark) const { return this->units[landmark]; }
+    const SearchOptions& options() const { return this->mOptions; }
+    // Bounds only hold for searches with the same steps
+    bool covers(const SearchOptions& options) const {
+        return options.connectivity == this->mOptions.connectivity
+            && options.cornerCutting == this->mOptions.cornerCutting;
+    }
+
+    // Row of cell: from and to landmark 0, from and to landmark 1, ...
+    const std::uint16_t* table() const { return this->mTable.get(); }
+    std::size_t tableSize() const { return std::size_t(this->mWidth) * this->mHeight * 2 * count(); }
+
+    // Lower bound of the cost from cell to goal, both cell indices
+    Cost lowerBound(int cell, int goal) const {
+        std::size_t row = std::size_t(2 * count());
+        const std::uint16_t* from = this->mTable.get() + std::size_t(cell) * row;
+        const std::uint16_t* to = this->mTable.get() + std::size_t(goal) * row;
+        std::uint64_t best = 0;
+        for (int k = 0; k < count(); ++k) {
+            int cellFrom = from[2 * k], goalFrom = to[2 * k];
+            int cellTo = from[2 * k + 1], goalTo = to[2 * k + 1];
+            // One unit less for the rounding of either value. Unreached
+            // minuends would give false gaps, unreached subtrahends
+            // only negative ones.
+            int gap = std::max(goalFrom == UNREACHED ? 0 : goalFrom - cellFrom - 1,
+                               cellTo == UNREACHED ? 0 : cellTo - goalTo - 1);
+            best = std::max(best, std::uint64_t(std::max(gap, 0)) * this->multipliers[k]);
+        }
+        return best >> 16;
+    }
+
+private:
+    int mWidth, mHeight;
+    SearchOptions mOptions;
+    std::vector<int> cells;
+    std::vector<std::uint32_t> units;
+    // Per landmark, unit * COST_SCALE / (COST_SCALE + unit) in 16 bit fixed point
+    std::vector<std::uint64_t> multipliers;
+    std::shared_ptr<const std::uint16_t> mTable;
+
+    void computeMultipliers();
+};
+
+#endif // LANDMARKS_H
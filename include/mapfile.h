@@ -0,0 +1,102 @@
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+#include "grid.h"
+#include "landmarks.h"
+#include "pathdatabase.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// A file mapped into memory with private copy-on-write pages: writes
+// never reach the file and only the touched pages get copied.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    char* data() { return this->mData; }
+    const char* data() const { return this->mData; }
+    std::size_t size() const { return this->mSize; }
+
+private:
+    char* mData = nullptr;
+    std::size_t mSize = 0;
+};
+
+// Packed bitmap file: a 64 byte header followed by the grid bitmap
+// words exactly as Grid keeps them in memory, so the file is searched
+// in place after mapping it. Terrain weights, if any, follow the
+// bitmap in the WeightedGrid layout.
+struct BitmapHeader {
+    char magic[8];          // "SPBITMAP"
+    std::uint32_t version;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t stride;   // 64 bit words per bitmap row
+    std::uint32_t weightBytes; // Bytes per terrain weight, 0 without any
+    char reserved[36];
+};
+static_assert(sizeof(BitmapHeader) == 64, "bitmap words have to stay 64 byte aligned");
+
+// Loaders throw std::runtime_error on unreadable or malformed files
+
+// Pick the format by extension: .bmap for packed bitmaps, anything else
+// is read as a MovingAI .map file
+WeightedGrid loadMap(const std::string& path);
+
+// Weight of swamp cells in MovingAI maps
+constexpr unsigned SWAMP_WEIGHT = 3;
+
+// MovingAI text format, '.', 'G' and 'S' are passable, swamps ('S')
+// get SWAMP_WEIGHT
+WeightedGrid loadMovingAiMap(const std::string& path);
+WeightedGrid parseMovingAiMap(const char* data, std::size_t size);
+
+WeightedGrid loadBitmap(const std::string& path);
+void saveBitmap(const WeightedGrid& grid, const std::string& path);
+
+// Landmark file: a 64 byte header, per landmark its cell and unit as
+// two uint32, then the distance table as Landmarks keeps it in memory,
+// so it is used in place after mapping the file
+struct LandmarkHeader {
+    char magic[8];          // "SPLANDMK"
+    std::uint32_t version;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t count;    // Landmarks
+    std::uint32_t connectivity;  // Connectivity and CornerCutting the distances were computed with
+    std::uint32_t cornerCutting;
+    char reserved[32];
+};
+static_assert(sizeof(LandmarkHeader) == 64, "the table has to stay aligned");
+
+// The table has to belong to a map of the size of grid
+std::shared_ptr<const Landmarks> loadLandmarks(const std::string& path, const Grid& grid);
+void saveLandmarks(const Landmarks& landmarks, const std::string& path);
+
+// Path database file: a 64 byte header, the target cells as uint32,
+// padded to eight bytes, the uint64 row offsets and then the runs, all
+// as PathDatabase keeps them in memory, so they are used in place after
+// mapping the file
+struct PathDatabaseHeader {
+    char magic[8];          // "SPPATHDB"
+    std::uint32_t version;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t targets;
+    std::uint32_t connectivity;  // Connectivity and CornerCutting the moves were computed with
+    std::uint32_t cornerCutting;
+    std::uint64_t runs;
+    char reserved[24];
+};
+static_assert(sizeof(PathDatabaseHeader) == 64, "the offsets have to stay aligned");
+
+// The rows have to belong to a map of the size of grid
+std::shared_ptr<const PathDatabase> loadPathDatabase(const std::string& path, const Grid& grid);
+void savePathDatabase(const PathDatabase& database, const std::string& path);
+
+#endif // MAPFILE_H
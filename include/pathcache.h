@@ -0,0 +1,84 @@
+#ifndef PATHCACHE_H
+#define PATHCACHE_H
+
+#include "grid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Bounded cache of search results, least recently used out first. A
+// result is keyed by the version of the grid, the algorithm, start,
+// goal and the options, so an edit of the map makes every older result
+// miss without clearing anything. Unreachable goals are cached too,
+// partial results and ARA* paths that may not be shortest are not.
+// Limits are not part of the key.
+//
+// Every part of a shortest path is a shortest path itself, so with
+// subPaths a query whose start and goal both lie on a cached path, in
+// that order, gets the part between them. HPA* paths are not shortest
+// ones and only answer the exact same query. Answers of hpa also depend
+// on the hierarchy, which should be built before the first query.
+//
+// Hits come back with nothing expanded and only the path in the trace.
+// Safe to share between threads.
+class PathCache {
+public:
+    explicit PathCache(std::size_t capacity = 1024, bool subPaths = true);
+
+    // The cached answer, else the one of grid.search, which is cached
+    SearchResult search(const WeightedGrid& grid, SearchSpace& space, Algorithm algorithm, Coordinates start,
+                        Coordinates goal, SearchTrace* trace = nullptr, const SearchOptions& options = {});
+
+    // False if neither the query nor a path it lies on is cached
+    bool find(const WeightedGrid& grid, Algorithm algorithm, Coordinates start, Coordinates goal,
+              const SearchOptions& options, SearchResult& result, SearchTrace* trace = nullptr);
+    void insert(const WeightedGrid& grid, Algorithm algorithm, Coordinates start, Coordinates goal,
+                const SearchOptions& options, const SearchResult& result);
+    void clear();
+
+    std::size_t size() const;
+    std::size_t capacity() const { return this->mCapacity; }
+    // Lookups since construction or clear()
+    std::size_t hits() const;
+    std::size_t subPathHits() const;
+    std::size_t misses() const;
+
+private:
+    struct Key {
+        std::uint64_t version;
+        Algorithm algorithm;
+        Coordinates start, goal;
+        SearchOptions options;
+        // Same query but for the endpoints
+        bool sameSearch(const Key& other) const;
+        bool operator==(const Key& other) const;
+    };
+    struct Hash {
+        std::size_t operator()(const Key& key) const;
+    };
+    struct Entry {
+        Key key;
+        SearchResult result;
+        // Cost from the start to each cell of the path, scale times that
+        // of SearchResult
+        std::vector<Cost> costs;
+        double scale;
+        std::unordered_map<int, int> positions; // Cell to index into the path
+    };
+
+    std::size_t mCapacity;
+    bool subPaths;
+    mutable std::mutex mutex;
+    std::list<Entry> entries; // Most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, Hash> lookup;
+    std::unordered_multimap<int, std::list<Entry>::iterator> through; // Cached paths through a cell
+    std::size_t mHits = 0, mSubPathHits = 0, mMisses = 0;
+
+    void evict();
+};
+
+#endif // PATHCACHE_H
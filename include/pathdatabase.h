@@ -0,0 +1,84 @@
+#ifndef PATHDATABASE_H
+#define PATHDATABASE_H
+
+#include "grid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Compressed path database: for each of a set of targets, the first
+// move of a shortest path from every open cell to it. A query walks the
+// moves from the start instead of searching, and adds up the exact
+// cost on the way. With every open cell as a target it answers all
+// pairs.
+//
+// Each target gets a row of first moves from a Dijkstra backwards from
+// it. The open cells of a row go in Z-order, which keeps cells close on
+// the map close in the row, and cells with the same move become one
+// run: a uint32 of the Z-order code of its first cell shifted left by
+// four bits and the move in those. Where several moves start a shortest
+// path, a run takes any move that all of its cells allow, so it only
+// ends where none is left. A lookup is a binary search in the row.
+// Cells inside obstacles have no move and never break a run.
+//
+// Maps up to MAX_SIDE cells a side, so codes fit in 28 bits. Read only
+// once built, so threads can share a database.
+class PathDatabase {
+public:
+    static constexpr int MAX_SIDE = 1 << 14;
+    // Move of the target and of cells that cannot reach it
+    static constexpr std::uint8_t NONE = 15;
+
+    // Rows for targets under the steps of options, built on threads
+    // threads, 0 uses all cores. Targets outside the map are left out.
+    PathDatabase(const WeightedGrid& grid, const std::vector<Coordinates>& targets,
+                 const SearchOptions& options = {}, unsigned threads = 0);
+    // View rows laid out as below, e.g. in a mapped file
+    PathDatabase(int width, int height, const SearchOptions& options, std::vector<int> targets,
+                 std::shared_ptr<const std::uint64_t> offsets, std::shared_ptr<const std::uint32_t> runs);
+
+    int width() const { return this->mWidth; }
+    int height() const { return this->mHeight; }
+    const SearchOptions& options() const { return this->mOptions; }
+    // Moves only hold for searches with the same steps
+    bool covers(const SearchOptions& options) const {
+        return options.connectivity == this->mOptions.connectivity
+            && options.cornerCutting == this->mOptions.cornerCutting;
+    }
+
+    int targetCount() const { return int(this->targets.size()); }
+    int target(int row) const { return this->targets[row]; }
+    // Row of the target in cell, -1 if it has none
+    int row(int cell) const {
+        auto found = this->rows.find(cell);
+        return found == this->rows.end() ? -1 : found->second;
+    }
+
+    // Runs of row r are runs()[offsets()[r]] up to runs()[offsets()[r + 1]]
+    const std::uint64_t* offsets() const { return this->mOffsets.get(); }
+    const std::uint32_t* runs() const { return this->mRuns.get(); }
+    std::size_t runCount() const { return std::size_t(this->mOffsets.get()[this->targets.size()]); }
+
+    // Index of Grid::DELTA to step in from the open cell id towards the
+    // target of row, NONE at the target or without a path
+    std::uint8_t move(int row, Coordinates id) const;
+
+    // Shortest path from start to goal, empty without a row for goal, a
+    // start inside an obstacle or no path. Expands nothing. Only valid
+    // on the grid the rows were built on.
+    SearchResult path(const WeightedGrid& grid, Coordinates start, Coordinates goal,
+                      SearchTrace* trace = nullptr) const;
+
+private:
+    int mWidth, mHeight;
+    SearchOptions mOptions;
+    std::vector<int> targets;
+    std::unordered_map<int, int> rows;
+    std::shared_ptr<const std::uint64_t> mOffsets;
+    std::shared_ptr<const std::uint32_t> mRuns;
+};
+
+#endif // PATHDATABASE_H
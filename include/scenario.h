@@ -0,0 +1,20 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "helper.h"
+
+#include <string>
+#include <vector>
+
+// One start/goal pair of a scenario file
+struct Query {
+    Coordinates start, goal;
+    double referenceLength = -1; // Optimal length stored in the file, -1 if unknown
+};
+
+// MovingAI .scen file: a "version" line followed by lines of
+// "bucket map width height startX startY goalX goalY optimalLength".
+// Throws std::runtime_error on unreadable or malformed files.
+std::vector<Query> loadScenario(const std::string& path);
+
+#endif // SCENARIO_H
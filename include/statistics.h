@@ -0,0 +1,82 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include "grid.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Counts of values in buckets four to an octave. Quantiles take the
+// values of a bucket as evenly spread over it, so they are off by at
+// most a fifth. Any thread may add, without locks.
+class Histogram {
+public:
+    static constexpr int BUCKETS = 252;
+
+    void add(std::uint64_t value);
+    void clear();
+
+    std::uint64_t count() const { return this->mCount.load(std::memory_order_relaxed); }
+    std::uint64_t sum() const { return this->mSum.load(std::memory_order_relaxed); }
+    std::uint64_t max() const { return this->mMax.load(std::memory_order_relaxed); }
+    std::uint64_t bucketCount(int bucket) const { return this->counts[bucket].load(std::memory_order_relaxed); }
+    // Estimate of the q-th quantile within its bucket and at most max(),
+    // 0 if empty
+    std::uint64_t quantile(double q) const;
+
+    static int bucket(std::uint64_t value);
+    // Smallest value of a bucket
+    static std::uint64_t lowerBound(int bucket);
+
+private:
+    std::array<std::atomic<std::uint64_t>, BUCKETS> counts{};
+    std::atomic<std::uint64_t> mCount{0}, mSum{0}, mMax{0};
+};
+
+// Process wide record of queries per algorithm: how many found a path,
+// how many were stopped by their limits, the totals of their
+// SearchStats, and histograms of their latencies and expanded nodes.
+// Recording takes no locks, so every thread of a batch may record.
+class SearchStatistics {
+public:
+    void record(Algorithm algorithm, const SearchResult& result, double latencyUs);
+    void clear();
+
+    std::uint64_t queries(Algorithm algorithm) const { return at(algorithm).latencyNs.count(); }
+    // In nanoseconds
+    const Histogram& latencies(Algorithm algorithm) const { return at(algorithm).latencyNs; }
+    const Histogram& expansions(Algorithm algorithm) const { return at(algorithm).expanded; }
+
+    // Every algorithm with queries, latencies in microseconds:
+    // {"stats": true, "algorithms": {"astar": {"queries": ..., "found": ...,
+    //  "partial": ..., "pushes": ..., "stale_pops": ..., "relaxations": ...,
+    //  "re_relaxations": ..., "setup_us": ..., "search_us": ..., "path_us": ...,
+    //  "latency_us": {"mean": ..., "p50": ..., "p90": ..., "p99": ..., "max": ...,
+    //                 "buckets": [[lower bound, count], ...]},
+    //  "expanded": {...}}}}
+    std::string json() const;
+    // A few lines on one algorithm, for the GUI
+    std::string summary(Algorithm algorithm) const;
+
+private:
+    // Keep up with the last algorithm
+    static constexpr int ALGORITHMS = int(Algorithm::anytime) + 1;
+    struct Totals {
+        std::atomic<std::uint64_t> found{0}, partial{0};
+        std::atomic<std::uint64_t> pushes{0}, stalePops{0}, relaxations{0}, reRelaxations{0};
+        std::atomic<std::uint64_t> setupNs{0}, searchNs{0}, pathNs{0};
+        Histogram latencyNs, expanded;
+    };
+    std::array<Totals, ALGORITHMS> algorithms;
+
+    Totals& at(Algorithm algorithm) { return this->algorithms[std::size_t(algorithm)]; }
+    const Totals& at(Algorithm algorithm) const { return this->algorithms[std::size_t(algorithm)]; }
+};
+
+// The one WeightedGrid::search records into with PATHSEARCH_STATS
+SearchStatistics& searchStatistics();
+
+#endif // STATISTICS_H
@@ -0,0 +1,77 @@
+#include "batch.h"
+#include "flowfield.h"
+#include "pathcache.h"
+#include "statistics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <thread>
+
+// One field per goal, built on all threads, which every query to that
+// goal walks down. Each query is charged its share of the field.
+static std::vector<BatchResult> flowBatch(const WeightedGrid& grid, const std::vector<Query>& queries,
+                                          unsigned threads, const SearchOptions& options) {
+    std::vector<BatchResult> results(queries.size());
+    std::map<Coordinates, std::vector<std::size_t>> byGoal;
+    for (std::size_t i = 0; i < queries.size(); ++i)
+        byGoal[queries[i].goal].push_back(i);
+    for (const auto& goal : byGoal) {
+        auto t0 = std::chrono::steady_clock::now();
+        FlowField field(grid, goal.first, options, threads);
+        auto t1 = std::chrono::steady_clock::now();
+        double shareUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / goal.second.size();
+        for (std::size_t i : goal.second) {
+            auto t2 = std::chrono::steady_clock::now();
+            results[i].result = field.path(grid, queries[i].start);
+            auto t3 = std::chrono::steady_clock::now();
+            results[i].result.expanded = field.expanded() / goal.second.size();
+            results[i].latencyUs = shareUs + std::chrono::duration<double, std::micro>(t3 - t2).count();
+            // Fields are not built through WeightedGrid::search, which records the other queries
+            if constexpr (SEARCH_STATS)
+                searchStatistics().record(Algorithm::flowField, results[i].result, results[i].latencyUs);
+        }
+    }
+    return results;
+}
+
+std::vector<BatchResult> searchBatch(const WeightedGrid& grid, Algorithm algorithm,
+                                     const std::vector<Query>& queries, unsigned threads,
+                                     const SearchOptions& options, PathCache* cache) {
+    if (algorithm == Algorithm::flowField) return flowBatch(grid, queries, threads, options);
+    std::vector<BatchResult> results(queries.size());
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(1, queries.size())));
+
+    // Chunks keep the shared counter cold while still balancing queries
+    // whose cost differs by orders of magnitude
+    constexpr std::size_t chunk = 16;
+    std::atomic<std::size_t> next{0};
+
+    auto worker = [&]() {
+        SearchSpace space;
+        for (;;) {
+            std::size_t begin = next.fetch_add(chunk, std::memory_order_relaxed);
+            if (begin >= queries.size()) break;
+            std::size_t end = std::min(queries.size(), begin + chunk);
+            for (std::size_t i = begin; i < end; ++i) {
+                auto t0 = std::chrono::steady_clock::now();
+                results[i].result = cache ? cache->search(grid, space, algorithm, queries[i].start,
+                                                          queries[i].goal, nullptr, options)
+                                          : grid.search(space, algorithm, queries[i].start, queries[i].goal,
+                                                        nullptr, options);
+                auto t1 = std::chrono::steady_clock::now();
+                results[i].latencyUs = std::chrono::duration<double, std::micro>(t1 - t0).count();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool)
+        thread.join();
+    return results;
+}
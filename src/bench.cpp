@@ -0,0 +1,292 @@
+#include "components.h"
+#include "grid.h"
+#include "mapfile.h"
+
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// Heap use of the whole process. Blocks come straight from malloc and
+// frees ask it how large they were, so every form of new and delete,
+// aligned and nothrow ones included, is counted alike.
+static std::atomic<std::int64_t> allocations{0};
+static std::atomic<std::int64_t> liveBytes{0};
+static std::atomic<std::int64_t> peakBytes{0};
+
+static void* counted(void* block) {
+    if (!block) return nullptr;
+    std::int64_t size = std::int64_t(malloc_usable_size(block));
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    std::int64_t live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    std::int64_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    return block;
+}
+
+static void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+    size = std::max<std::size_t>(size, 1);
+    if (alignment <= alignof(std::max_align_t)) return counted(std::malloc(size));
+    // aligned_alloc wants a multiple of the alignment
+    return counted(std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment));
+}
+
+static void release(void* block) noexcept {
+    if (!block) return;
+    liveBytes.fetch_sub(std::int64_t(malloc_usable_size(block)), std::memory_order_relaxed);
+    std::free(block);
+}
+
+static void* allocateOrThrow(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+    void* block = allocate(size, alignment);
+    if (!block) throw std::bad_alloc();
+    return block;
+}
+
+void* operator new(std::size_t size) { return allocateOrThrow(size); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, std::size_t(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, std::size_t(alignment));
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, std::size_t(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, std::size_t(alignment));
+}
+
+void operator delete(void* pointer) noexcept { release(pointer); }
+void operator delete[](void* pointer) noexcept { release(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { release(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { release(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { release(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { release(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { release(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { release(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { release(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { release(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { release(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { release(pointer); }
+
+namespace {
+// Search modes: every algorithm, and the ones that can search from both ends doing so
+struct Mode {
+    const char* name;
+    Algorithm algorithm;
+    bool bidirectional;
+};
+const Mode MODES[] = {
+    {"bfs", Algorithm::breadthFirst, false},
+    {"bfs-bidirectional", Algorithm::breadthFirst, true},
+    {"dijkstra", Algorithm::dijkstra, false},
+    {"dijkstra-bidirectional", Algorithm::dijkstra, true},
+    {"astar", Algorithm::astar, false},
+    {"astar-bidirectional", Algorithm::astar, true},
+    {"jps", Algorithm::jps, false},
+    {"wavefront", Algorithm::wavefront, false},
+    {"hpa", Algorithm::hpa, false},
+    {"dstar", Algorithm::dstarLite, false},
+    {"alt", Algorithm::alt, false},
+    {"flow", Algorithm::flowField, false},
+    {"cpd", Algorithm::pathDatabase, false},
+    {"ara", Algorithm::anytime, false},
+};
+const int SIZES[] = {64, 256, 1024};
+constexpr int QUERIES = 64;
+
+WeightedGrid openMap(int size) {
+    return WeightedGrid(size, size);
+}
+
+WeightedGrid randomMap(int size) {
+    std::mt19937 random(size);
+    WeightedGrid grid(size, size);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            if (random() % 100 < 30) grid.setObstacle({x, y});
+        }
+    }
+    return grid;
+}
+
+// Corridors carved by a depth first walk between the cells of odd
+// coordinates, then one wall in twenty knocked out so there are loops
+WeightedGrid mazeMap(int size) {
+    std::mt19937 random(size);
+    WeightedGrid grid(size, size);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            if (x % 2 == 0 || y % 2 == 0) grid.setObstacle({x, y});
+        }
+    }
+    std::vector<bool> seen(std::size_t(size) * size, false);
+    std::vector<Coordinates> stack{{1, 1}};
+    seen[std::size_t(size) + 1] = true;
+    while (!stack.empty()) {
+        Coordinates id = stack.back();
+        Coordinates options[4];
+        int count = 0;
+        for (int direction = 0; direction < 4; ++direction) {
+            Coordinates next{id.x + 2 * Grid::DELTA[direction].x, id.y + 2 * Grid::DELTA[direction].y};
+            if (next.x > 0 && next.y > 0 && next.x < size - 1 && next.y < size - 1
+                    && !seen[std::size_t(next.y) * size + next.x])
+                options[count++] = next;
+        }
+        if (count == 0) {
+            stack.pop_back();
+            continue;
+        }
+        Coordinates next = options[random() % count];
+        seen[std::size_t(next.y) * size + next.x] = true;
+        grid.setObstacle({(id.x + next.x) / 2, (id.y + next.y) / 2}, false);
+        stack.push_back(next);
+    }
+    for (int y = 1; y < size - 1; ++y) {
+        for (int x = 1; x < size - 1; ++x) {
+            if ((x + y) % 2 == 1 && random() % 20 == 0) grid.setObstacle({x, y}, false);
+        }
+    }
+    return grid;
+}
+
+// A map and start/goal pairs that are connected
+struct Workload {
+    WeightedGrid grid;
+    std::vector<std::pair<Coordinates, Coordinates>> queries;
+};
+
+std::shared_ptr<const Workload> makeWorkload(WeightedGrid grid) {
+    auto workload = std::make_shared<Workload>(Workload{std::move(grid), {}});
+    const WeightedGrid& map = workload->grid;
+    Components components(map);
+    std::mt19937 random(map.cellCount());
+    auto randomCell = [&]() {
+        for (;;) {
+            Coordinates id{int(random() % map.width()), int(random() % map.height())};
+            if (map.passable(id)) return id;
+        }
+    };
+    for (int attempt = 0; workload->queries.size() < QUERIES && attempt < 100 * QUERIES; ++attempt) {
+        Coordinates start = randomCell(), goal = randomCell();
+        if (components.component(map.index(start)) == components.component(map.index(goal)))
+            workload->queries.emplace_back(start, goal);
+    }
+    return workload;
+}
+
+// Workloads are built on first use, so a filtered run only builds its own
+std::shared_ptr<const Workload> workload(const std::string& name, int size) {
+    static std::map<std::pair<std::string, int>, std::shared_ptr<const Workload>> workloads;
+    auto& cached = workloads[{name, size}];
+    if (!cached) {
+        if (name == "open") cached = makeWorkload(openMap(size));
+        else if (name == "random") cached = makeWorkload(randomMap(size));
+        else if (name == "maze") cached = makeWorkload(mazeMap(size));
+        else cached = makeWorkload(loadMap(std::string(MAPS_DIR) + "/" + name + ".map"));
+    }
+    return cached;
+}
+
+std::int64_t peakRssKiB() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+void runQueries(benchmark::State& state, const Mode& mode, const std::string& map, int size) {
+    std::shared_ptr<const Workload> work = workload(map, size);
+    if (work->queries.empty()) {
+        state.SkipWithError("no connected start and goal");
+        return;
+    }
+    // Precomputed outside the timing, like the runner does
+    WeightedGrid grid = work->grid;
+    SearchOptions options;
+    options.bidirectional = mode.bidirectional;
+    if (mode.algorithm == Algorithm::jps) grid.precomputeJumps();
+    if (mode.algorithm == Algorithm::hpa) grid.buildHierarchy();
+    if (mode.algorithm == Algorithm::alt) grid.buildLandmarks(8, options);
+    if (mode.algorithm == Algorithm::pathDatabase) {
+        std::vector<Coordinates> goals;
+        for (const auto& query : work->queries)
+            goals.push_back(query.second);
+        grid.buildPathDatabase(goals, options);
+    }
+
+    // Scratch arrays sized by a first query, later ones reuse them
+    SearchSpace space;
+    grid.search(space, mode.algorithm, work->queries[0].first, work->queries[0].second, nullptr, options);
+
+    std::size_t next = 0;
+    std::int64_t expanded = 0;
+    SearchStats stats;
+    std::int64_t allocationsBefore = allocations.load();
+    std::int64_t liveBefore = liveBytes.load();
+    peakBytes.store(liveBefore);
+    for (auto _ : state) {
+        const auto& query = work->queries[next];
+        next = next + 1 == work->queries.size() ? 0 : next + 1;
+        SearchResult result = grid.search(space, mode.algorithm, query.first, query.second, nullptr, options);
+        expanded += std::int64_t(result.expanded);
+        if constexpr (SEARCH_STATS) {
+            stats.pushes += result.stats.pushes;
+            stats.stalePops += result.stats.stalePops;
+            stats.reRelaxations += result.stats.reRelaxations;
+        }
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["expanded"] = benchmark::Counter(double(expanded), benchmark::Counter::kAvgIterations);
+    state.counters["nodes/s"] = benchmark::Counter(double(expanded), benchmark::Counter::kIsRate);
+    state.counters["allocs"] = benchmark::Counter(double(allocations.load() - allocationsBefore),
+                                                  benchmark::Counter::kAvgIterations);
+    state.counters["peakKiB"] = double(peakBytes.load() - liveBefore) / 1024;
+    state.counters["rssKiB"] = double(peakRssKiB());
+    if constexpr (SEARCH_STATS) {
+        state.counters["pushes"] = benchmark::Counter(double(stats.pushes), benchmark::Counter::kAvgIterations);
+        state.counters["stalePops"] = benchmark::Counter(double(stats.stalePops), benchmark::Counter::kAvgIterations);
+        state.counters["reRelaxed"] = benchmark::Counter(double(stats.reRelaxations),
+                                                         benchmark::Counter::kAvgIterations);
+    }
+}
+}
+
+// Names are mode/map/size, e.g. --benchmark_filter='astar/maze/.*'
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    for (const Mode& mode : MODES) {
+        for (int preset = 1; preset <= 5; ++preset) {
+            std::string map = "preset" + std::to_string(preset);
+            benchmark::RegisterBenchmark((std::string(mode.name) + "/" + map).c_str(),
+                                         [&mode, map](benchmark::State& state) { runQueries(state, mode, map, 0); });
+        }
+        for (const char* map : {"open", "random", "maze"}) {
+            for (int size : SIZES) {
+                benchmark::RegisterBenchmark((std::string(mode.name) + "/" + map + "/" + std::to_string(size)).c_str(),
+                                             [&mode, map, size](benchmark::State& state) {
+                    runQueries(state, mode, map, size);
+                });
+            }
+        }
+    }
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
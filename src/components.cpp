@@ -0,0 +1,220 @@
+#include "components.h"
+
+#include <algorithm>
+
+Components::Components(const Grid& grid, const SearchOptions& options)
+    : mOptions(options)
+    , labels(std::size_t(grid.cellCount()), NONE)
+{
+    // Runs of open cells, row by row, joined by union find. Cutting
+    // corners also joins runs that only touch diagonally.
+    struct Run {
+        int y, begin, end;
+    };
+    std::vector<Run> runs;
+    std::vector<int> parent;
+    auto find = [&parent](int run) {
+        while (parent[run] != run) run = parent[run] = parent[parent[run]];
+        return run;
+    };
+    const int corner = always(options) ? 1 : 0;
+    std::size_t previous = 0;
+    for (int y = 0; y < grid.height(); ++y) {
+        std::size_t first = runs.size(), above = previous;
+        for (int x = 0; x < grid.width();) {
+            if (!grid.passable(Coordinates{x, y})) {
+                ++x;
+                continue;
+            }
+            int begin = x;
+            while (x < grid.width() && grid.passable(Coordinates{x, y})) ++x;
+            int run = int(runs.size());
+            runs.push_back(Run{y, begin, x});
+            parent.push_back(run);
+            // Runs of a row are sorted, a run above may touch several below
+            while (above < first && runs[above].end + corner <= begin) ++above;
+            for (std::size_t other = above; other < first && runs[other].begin < x + corner; ++other)
+                parent[find(int(other))] = find(run);
+        }
+        previous = first;
+    }
+
+    // One label and component per tree of runs
+    std::vector<int> component(runs.size(), NONE);
+    for (std::size_t run = 0; run < runs.size(); ++run) {
+        int root = find(int(run));
+        if (component[root] == NONE) component[root] = newComponent();
+        int label = component[root];
+        this->sizes[label] += std::size_t(runs[run].end - runs[run].begin);
+        std::fill_n(this->labels.begin() + std::size_t(runs[run].y) * grid.width() + runs[run].begin,
+                    runs[run].end - runs[run].begin, label);
+    }
+}
+
+int Components::newComponent() {
+    int label = int(this->labelComponent.size());
+    this->labelComponent.push_back(label);
+    this->members.push_back({label});
+    this->sizes.push_back(0);
+    ++this->mCount;
+    return label;
+}
+
+void Components::merge(int a, int b) {
+    if (a == b) return;
+    if (this->members[a].size() < this->members[b].size()) std::swap(a, b);
+    for (int label : this->members[b])
+        this->labelComponent[label] = a;
+    this->members[a].insert(this->members[a].end(), this->members[b].begin(), this->members[b].end());
+    this->members[b].clear();
+    this->sizes[a] += this->sizes[b];
+    this->sizes[b] = 0;
+    --this->mCount;
+}
+
+bool Components::connected(const Grid& grid, Coordinates start, Coordinates goal) const {
+    int startCell = grid.index(start), goalCell = grid.index(goal);
+    if (startCell == goalCell) return true;
+    int target = component(goalCell);
+    if (target == NONE) return false;
+    if (this->labels[startCell] != NONE) return component(startCell) == target;
+    bool found = false;
+    grid.forEachNeighbor(start, this->mOptions.connectivity, this->mOptions.cornerCutting,
+                         [&](Coordinates, int nextCell, int) {
+        found = found || component(nextCell) == target;
+    });
+    return found;
+}
+
+void Components::update(const Grid& grid, Coordinates id) {
+    if (!grid.inBounds(id)) return;
+    int cell = grid.index(id);
+    bool open = grid.passable(id);
+    if (open == (this->labels[cell] != NONE)) return;
+
+    if (open) {
+        // Joins the components of its neighbors, or starts one
+        int joined = NONE;
+        grid.forEachNeighbor(id, this->mOptions.connectivity, this->mOptions.cornerCutting,
+                             [&](Coordinates, int nextCell, int) {
+            if (joined == NONE) {
+                this->labels[cell] = this->labels[nextCell];
+                joined = component(nextCell);
+            } else {
+                merge(joined, component(nextCell));
+                joined = component(cell);
+            }
+        });
+        if (joined == NONE) this->labels[cell] = joined = newComponent();
+        ++this->sizes[joined];
+        return;
+    }
+
+    int old = component(cell);
+    this->labels[cell] = NONE;
+    if (--this->sizes[old] == 0) {
+        --this->mCount;
+        return;
+    }
+    split(grid, cell, old);
+}
+
+// Paths through a closed cell can go around it if the open cells of its
+// component next to it still meet without it. Otherwise one search per
+// group of them runs in lockstep, searches that meet go on as one, and
+// each group that runs out before the others is a piece of its own.
+// The last one keeps the old labels, so the cost is that of the pieces
+// split off, not of the whole component.
+void Components::split(const Grid& grid, int cell, int old) {
+    Coordinates id = grid.coordinates(cell);
+    int around[8], group[8], count = 0;
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            Coordinates next{id.x + dx, id.y + dy};
+            if ((dx || dy) && grid.inBounds(next) && component(grid.index(next)) == old) {
+                group[count] = count;
+                around[count++] = grid.index(next);
+            }
+        }
+    }
+    auto root = [&group](int i) {
+        while (group[i] != i) i = group[i];
+        return i;
+    };
+    for (int i = 0; i < count; ++i) {
+        grid.forEachNeighbor(grid.coordinates(around[i]), this->mOptions.connectivity,
+                             this->mOptions.cornerCutting, [&](Coordinates, int nextCell, int) {
+            for (int j = 0; j < count; ++j) {
+                if (around[j] == nextCell) group[root(j)] = root(i);
+            }
+        });
+    }
+    int searches = 0, seeds[8];
+    for (int i = 0; i < count; ++i) {
+        if (root(i) == i) seeds[searches++] = around[i];
+    }
+    if (searches <= 1) return;
+
+    if (this->stamp.size() != this->labels.size()) {
+        this->stamp.assign(this->labels.size(), 0);
+        this->owner.assign(this->labels.size(), 0);
+        this->generation = 0;
+    }
+    if (++this->generation == 0) {
+        std::fill(this->stamp.begin(), this->stamp.end(), 0);
+        this->generation = 1;
+    }
+    this->reached.resize(std::size_t(searches));
+    std::size_t heads[8];
+    int merged[8];
+    bool done[8];
+    for (int s = 0; s < searches; ++s) {
+        this->reached[s].assign(1, seeds[s]);
+        this->stamp[seeds[s]] = this->generation;
+        this->owner[seeds[s]] = std::uint8_t(s);
+        heads[s] = 0;
+        merged[s] = s;
+        done[s] = false;
+    }
+    auto find = [&merged](int s) {
+        while (merged[s] != s) s = merged[s];
+        return s;
+    };
+
+    int remaining = searches;
+    while (remaining > 1) {
+        for (int s = 0; s < searches && remaining > 1; ++s) {
+            if (done[find(s)] || heads[s] == this->reached[s].size()) continue;
+            int current = this->reached[s][heads[s]++];
+            grid.forEachNeighbor(grid.coordinates(current), this->mOptions.connectivity,
+                                 this->mOptions.cornerCutting, [&](Coordinates, int nextCell, int) {
+                if (this->stamp[nextCell] != this->generation) {
+                    this->stamp[nextCell] = this->generation;
+                    this->owner[nextCell] = std::uint8_t(s);
+                    this->reached[s].push_back(nextCell);
+                } else if (find(this->owner[nextCell]) != find(s)) {
+                    merged[find(this->owner[nextCell])] = find(s);
+                    --remaining;
+                }
+            });
+
+            int piece = find(s);
+            bool exhausted = true;
+            for (int t = 0; t < searches; ++t) {
+                if (find(t) == piece && heads[t] < this->reached[t].size()) exhausted = false;
+            }
+            if (!exhausted || remaining <= 1) continue;
+            // Split off with a component of its own
+            int split = newComponent();
+            for (int t = 0; t < searches; ++t) {
+                if (find(t) != piece) continue;
+                for (int reachedCell : this->reached[t])
+                    this->labels[reachedCell] = split;
+                this->sizes[split] += this->reached[t].size();
+            }
+            this->sizes[old] -= this->sizes[split];
+            done[piece] = true;
+            --remaining;
+        }
+    }
+}
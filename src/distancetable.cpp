@@ -0,0 +1,81 @@
+#include "distancetable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+DistanceTable::DistanceTable(const WeightedGrid& grid, std::vector<Coordinates> sources,
+                             std::vector<Coordinates> targets, const SearchOptions& options, unsigned threads)
+    : mSources(std::move(sources))
+    , mTargets(std::move(targets))
+    , costs(this->mSources.size() * this->mTargets.size(), UNREACHABLE)
+{
+    // Targets sharing a cell share a slot, cells outside the map get none
+    std::vector<int> cells;
+    for (Coordinates target : this->mTargets) {
+        if (grid.inBounds(target)) cells.push_back(grid.index(target));
+    }
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+    std::vector<int> slots(std::size_t(grid.cellCount()), -1);
+    for (std::size_t slot = 0; slot < cells.size(); ++slot)
+        slots[cells[slot]] = int(slot);
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(1, this->mSources.size())));
+    std::atomic<std::size_t> next{0}, expanded{0};
+    auto worker = [&]() {
+        SearchSpace space;
+        std::vector<Cost> found(cells.size());
+        std::size_t count = 0;
+        for (;;) {
+            std::size_t source = next.fetch_add(1, std::memory_order_relaxed);
+            if (source >= this->mSources.size()) break;
+            Coordinates start = this->mSources[source];
+            if (!grid.inBounds(start)) continue;
+
+            std::fill(found.begin(), found.end(), UNREACHABLE);
+            std::size_t remaining = cells.size();
+            space.reset(std::size_t(grid.cellCount()));
+            RadixHeap& frontier = space.radix;
+            frontier.reset(std::size_t(grid.cellCount()));
+            int startCell = grid.index(start);
+            space.reach(startCell, startCell, 0);
+            frontier.put(startCell, 0);
+            while (!frontier.empty() && remaining > 0) {
+                Cost cost;
+                int current = frontier.get(cost);
+                if (cost > space.cost(current)) continue;
+                ++count;
+                if (slots[current] >= 0) {
+                    found[slots[current]] = cost;
+                    --remaining;
+                }
+                Coordinates id = grid.coordinates(current);
+                grid.forEachNeighbor(id, options.connectivity, options.cornerCutting,
+                                     [&](Coordinates nextId, int nextCell, int direction) {
+                    Cost newCost = cost + grid.weight(nextId) * stepCost(id, direction);
+                    if (!space.reached(nextCell) || newCost < space.cost(nextCell)) {
+                        space.reach(nextCell, current, newCost);
+                        frontier.put(nextCell, newCost);
+                    }
+                });
+            }
+
+            Cost* row = this->costs.data() + source * this->mTargets.size();
+            for (std::size_t target = 0; target < this->mTargets.size(); ++target) {
+                Coordinates id = this->mTargets[target];
+                if (grid.inBounds(id)) row[target] = found[slots[grid.index(id)]];
+            }
+        }
+        expanded.fetch_add(count, std::memory_order_relaxed);
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool)
+        thread.join();
+    this->mExpanded = expanded.load();
+}
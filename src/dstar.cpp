@@ -0,0 +1,199 @@
+#include "dstar.h"
+
+#include <algorithm>
+
+// Sum that stays infinite
+static Cost add(Cost a, Cost b) {
+    return a == ~Cost(0) || b == ~Cost(0) ? ~Cost(0) : a + b;
+}
+
+DStarLite::DStarLite(const WeightedGrid& grid, Coordinates start, Coordinates goal, const SearchOptions& options)
+    : options(options)
+    , mWidth(grid.width())
+    , mHeight(grid.height())
+    , mStart(start)
+    , mGoal(goal)
+    , last(start)
+    , g(std::size_t(grid.cellCount()))
+    , rhs(std::size_t(grid.cellCount()))
+    , stamp(std::size_t(grid.cellCount()), 0)
+{
+    setGoal(goal);
+}
+
+// Every queued key stays a lower bound of its current one, since the
+// start only moves as far as km grows
+void DStarLite::setStart(Coordinates start) {
+    this->km += heuristic(this->last, start, this->options.connectivity);
+    this->last = this->mStart = start;
+}
+
+void DStarLite::setGoal(Coordinates goal) {
+    this->mGoal = goal;
+    this->km = 0;
+    this->last = this->mStart;
+    if (++this->generation == 0) {
+        std::fill(this->stamp.begin(), this->stamp.end(), 0);
+        this->generation = 1;
+    }
+    this->open.reset(this->stamp.size());
+    if (!inBounds(goal)) return;
+    int cell = index(goal);
+    touch(cell);
+    this->rhs[cell] = 0;
+    update(cell);
+}
+
+DStarLite::Key DStarLite::key(int cell) const {
+    Cost cost = std::min(this->g[cell], this->rhs[cell]);
+    if (cost == INFINITE) return Key{INFINITE, INFINITE};
+    return Key{cost + heuristic(this->mStart, coordinates(cell), this->options.connectivity) + this->km, cost};
+}
+
+bool DStarLite::update(int cell) {
+    if (this->g[cell] != this->rhs[cell]) {
+        this->open.put(cell, key(cell));
+        return true;
+    }
+    this->open.remove(cell);
+    return false;
+}
+
+Cost DStarLite::lookahead(const WeightedGrid& grid, int cell) const {
+    Cost best = INFINITE;
+    grid.forEachNeighbor(coordinates(cell), this->options.connectivity, this->options.cornerCutting,
+                         [&](Coordinates next, int nextCell, int direction) {
+        if (this->stamp[nextCell] != this->generation) return;
+        best = std::min(best, add(this->g[nextCell], grid.weight(next) * stepCost(coordinates(cell), direction)));
+    });
+    return best;
+}
+
+// Steps between open cells go both ways. Nothing steps into an obstacle,
+// but a start inside one still has steps out of it.
+template <class Visit>
+void DStarLite::forEachPredecessor(const WeightedGrid& grid, int cell, Visit&& visit) const {
+    Coordinates id = coordinates(cell);
+    if (!grid.passable(id)) return;
+    grid.forEachNeighbor(id, this->options.connectivity, this->options.cornerCutting,
+                         [&](Coordinates previous, int previousCell, int) {
+        visit(previousCell, grid.cost(previous, id));
+    });
+    if (inBounds(this->mStart) && !grid.passable(this->mStart)) {
+        grid.forEachNeighbor(this->mStart, this->options.connectivity, this->options.cornerCutting,
+                             [&](Coordinates next, int nextCell, int) {
+            if (nextCell == cell) visit(index(this->mStart), grid.cost(this->mStart, next));
+        });
+    }
+}
+
+// Only the steps into and out of id change, and with eight directions
+// also the diagonal steps passing its corners. All of them start at id
+// or at one of its neighbors.
+void DStarLite::cellChanged(const WeightedGrid& grid, Coordinates id) {
+    if (!inBounds(id) || !inBounds(this->mGoal)) return;
+    int goalCell = index(this->mGoal);
+    for (int y = std::max(id.y - 1, 0); y <= std::min(id.y + 1, this->mHeight - 1); ++y) {
+        for (int x = std::max(id.x - 1, 0); x <= std::min(id.x + 1, this->mWidth - 1); ++x) {
+            int cell = index(Coordinates{x, y});
+            if (cell == goalCell) continue;
+            touch(cell);
+            this->rhs[cell] = lookahead(grid, cell);
+            update(cell);
+        }
+    }
+}
+
+SearchResult DStarLite::plan(const WeightedGrid& grid, SearchTrace* trace) {
+    SearchResult result;
+    if (trace) trace->clear();
+    if (!inBounds(this->mStart) || !inBounds(this->mGoal)) return result;
+    PhaseTimer timer;
+    int startCell = index(this->mStart), goalCell = index(this->mGoal);
+    touch(startCell);
+    // Nothing keeps the lookahead of an obstacle up to date until it is the start
+    if (!grid.passable(this->mStart) && startCell != goalCell) {
+        this->rhs[startCell] = lookahead(grid, startCell);
+        update(startCell);
+    }
+
+    // Until the start is locally consistent and no queued cell could
+    // still lower its cost
+    while (!this->open.empty()
+           && (this->open.top().first < key(startCell) || this->rhs[startCell] > this->g[startCell])) {
+        int cell = this->open.top().second;
+        Key old = this->open.top().first, current = key(cell);
+        ++result.expanded;
+        if (trace) trace->visit(cell);
+        if (old < current) {
+            if constexpr (SEARCH_STATS) ++result.stats.pushes;
+            this->open.put(cell, current);
+        } else if (this->g[cell] > this->rhs[cell]) {
+            // Cost went down, settle it and offer it to the predecessors
+            this->g[cell] = this->rhs[cell];
+            this->open.remove(cell);
+            forEachPredecessor(grid, cell, [&](int previous, Cost step) {
+                if (previous == goalCell) return;
+                touch(previous);
+                Cost cost = add(this->g[cell], step);
+                if (cost < this->rhs[previous]) {
+                    if constexpr (SEARCH_STATS) {
+                        result.stats.reRelaxations += this->rhs[previous] != INFINITE;
+                        ++result.stats.relaxations;
+                    }
+                    this->rhs[previous] = cost;
+                }
+                bool queued = update(previous);
+                if constexpr (SEARCH_STATS) result.stats.pushes += queued;
+            });
+        } else {
+            // Cost went up, everything that relied on it looks again
+            Cost oldCost = this->g[cell];
+            this->g[cell] = INFINITE;
+            forEachPredecessor(grid, cell, [&](int previous, Cost step) {
+                if (previous == goalCell) return;
+                touch(previous);
+                if (this->rhs[previous] == add(oldCost, step)) this->rhs[previous] = lookahead(grid, previous);
+                bool queued = update(previous);
+                if constexpr (SEARCH_STATS) result.stats.pushes += queued;
+            });
+            if (cell != goalCell) this->rhs[cell] = lookahead(grid, cell);
+            bool queued = update(cell);
+            if constexpr (SEARCH_STATS) result.stats.pushes += queued;
+        }
+    }
+
+    timer.lap(result.stats.searchUs);
+    // The start itself may be left unexpanded, its lookahead is exact
+    if (this->rhs[startCell] == INFINITE) return result;
+    // Walk down the costs to the goal
+    Coordinates id = this->mStart;
+    result.path.push_back(id);
+    for (int steps = 0; id != this->mGoal && steps < grid.cellCount(); ++steps) {
+        Cost best = INFINITE;
+        Coordinates bestNext = id;
+        grid.forEachNeighbor(id, this->options.connectivity, this->options.cornerCutting,
+                             [&](Coordinates next, int nextCell, int direction) {
+            if (this->stamp[nextCell] != this->generation) return;
+            Cost cost = add(this->g[nextCell], grid.weight(next) * stepCost(id, direction));
+            if (cost < best) {
+                best = cost;
+                bestNext = next;
+            }
+        });
+        if (best == INFINITE) break;
+        id = bestNext;
+        result.path.push_back(id);
+    }
+    timer.lap(result.stats.pathUs);
+    if (id != this->mGoal) {
+        result.path.clear();
+        return result;
+    }
+    if (trace) {
+        for (Coordinates step : result.path)
+            trace->path(index(step));
+    }
+    result.cost = double(this->rhs[startCell]) / COST_SCALE;
+    return result;
+}
@@ -0,0 +1,223 @@
+#include "flowfield.h"
+#include "frontier.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace {
+constexpr Cost UNREACHABLE = ~Cost(0);
+
+// Lowers value to candidate unless it is already as low, true if it was not
+bool lower(std::atomic<Cost>& value, Cost candidate) {
+    Cost current = value.load(std::memory_order_relaxed);
+    while (candidate < current) {
+        if (value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) return true;
+    }
+    return false;
+}
+
+// Calls work(thread) on threads threads, this one being thread 0
+template <class Work>
+void onThreads(unsigned threads, Work&& work) {
+    std::vector<std::thread> pool;
+    for (unsigned thread = 1; thread < threads; ++thread)
+        pool.emplace_back([&work, thread]() { work(thread); });
+    work(0u);
+    for (auto& thread : pool)
+        thread.join();
+}
+}
+
+FlowField::FlowField(const WeightedGrid& grid, Coordinates goal, const SearchOptions& options,
+                     unsigned threads, int tileSize)
+    : mWidth(grid.width())
+    , mHeight(grid.height())
+    , mGoal(goal)
+    , costs(std::size_t(grid.cellCount()), UNREACHED)
+    , directions(std::size_t(grid.cellCount()), NONE)
+{
+    if (!grid.inBounds(goal)) return;
+    PhaseTimer timer;
+    std::size_t cellCount = std::size_t(grid.cellCount());
+    int size = std::max(tileSize, 1);
+    int columns = (this->mWidth + size - 1) / size, rows = (this->mHeight + size - 1) / size;
+    int tileCount = columns * rows;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Cost to the goal shifted left by three bits and the direction of
+    // the step there in those, so one atomic minimum lowers both
+    std::unique_ptr<std::atomic<Cost>[]> labels(new std::atomic<Cost>[cellCount]);
+    for (std::size_t cell = 0; cell < cellCount; ++cell)
+        labels[cell].store(UNREACHABLE, std::memory_order_relaxed);
+    // Smallest label written into a tile from outside since it last ran
+    std::unique_ptr<std::atomic<Cost>[]> pending(new std::atomic<Cost>[std::size_t(tileCount)]);
+    for (int tile = 0; tile < tileCount; ++tile)
+        pending[tile].store(UNREACHABLE, std::memory_order_relaxed);
+    int goalCell = grid.index(goal);
+    auto tileOf = [size, columns](Coordinates id) { return id.y / size * columns + id.x / size; };
+    labels[goalCell].store(0, std::memory_order_relaxed);
+    pending[tileOf(goal)].store(0, std::memory_order_relaxed);
+
+    // Dijkstra inside one tile, from the labels on its border and the goal
+    auto settle = [&](int tile, RadixHeap& heap, SearchStats& stats) {
+        int left = tile % columns * size, top = tile / columns * size;
+        int right = std::min(left + size, this->mWidth), bottom = std::min(top + size, this->mHeight);
+        auto local = [&](Coordinates id) { return (id.y - top) * size + id.x - left; };
+        heap.reset(std::size_t(size) * size);
+        // Seeds go in before anything comes out, so priorities stay monotone
+        for (int y = top; y < bottom; ++y) {
+            // All of the first and the last row, both ends of the others
+            int step = y == top || y == bottom - 1 ? 1 : std::max(right - left - 1, 1);
+            for (int x = left; x < right; x += step) {
+                Cost label = labels[grid.index(Coordinates{x, y})].load(std::memory_order_relaxed);
+                if (label == UNREACHABLE) continue;
+                heap.put(local(Coordinates{x, y}), label);
+                if constexpr (SEARCH_STATS) ++stats.pushes;
+            }
+        }
+        if (tileOf(goal) == tile) {
+            heap.put(local(goal), 0);
+            if constexpr (SEARCH_STATS) ++stats.pushes;
+        }
+
+        std::size_t expanded = 0;
+        while (!heap.empty()) {
+            Cost label;
+            int item = heap.get(label);
+            Coordinates id{left + item % size, top + item / size};
+            // Outdated, or lowered by another tile, which will run again
+            if (label != labels[grid.index(id)].load(std::memory_order_relaxed)) {
+                if constexpr (SEARCH_STATS) ++stats.stalePops;
+                continue;
+            }
+            ++expanded;
+            // Nothing steps into a goal inside an obstacle
+            if (!grid.passable(id)) continue;
+            Cost cost = label >> 3, weight = grid.weight(id);
+            grid.forEachNeighbor(id, options.connectivity, options.cornerCutting,
+                                 [&](Coordinates next, int nextCell, int direction) {
+                // The step runs from next to id, in the opposite direction
+                int back = direction ^ (direction < 4 ? 1 : 3);
+                Cost candidate = (cost + weight * stepCost(next, back)) << 3 | Cost(back);
+                if (!lower(labels[nextCell], candidate)) return;
+                if constexpr (SEARCH_STATS) ++stats.relaxations;
+                if (tileOf(next) == tile) {
+                    heap.put(local(next), candidate);
+                    if constexpr (SEARCH_STATS) ++stats.pushes;
+                } else {
+                    lower(pending[tileOf(next)], candidate);
+                }
+            });
+        }
+        return expanded;
+    };
+
+    // Rounds run the tiles with the smallest pending labels, up to about
+    // the cost of crossing a tile above the smallest. Closer to the order
+    // of a single Dijkstra, tiles rarely settle a cell on a detour first.
+    Cost band = Cost(size) * COST_SCALE << 3;
+    std::vector<RadixHeap> heaps(threads);
+    std::vector<SearchStats> counters(threads);
+    std::vector<int> active;
+    std::size_t expanded = 0;
+    for (;;) {
+        Cost smallest = UNREACHABLE;
+        for (int tile = 0; tile < tileCount; ++tile)
+            smallest = std::min(smallest, pending[tile].load(std::memory_order_relaxed));
+        if (smallest == UNREACHABLE) break;
+        active.clear();
+        for (int tile = 0; tile < tileCount; ++tile) {
+            if (pending[tile].load(std::memory_order_relaxed) - smallest <= band) {
+                pending[tile].store(UNREACHABLE, std::memory_order_relaxed);
+                active.push_back(tile);
+            }
+        }
+        std::atomic<std::size_t> next{0}, count{0};
+        onThreads(static_cast<unsigned>(std::min<std::size_t>(threads, active.size())), [&](unsigned thread) {
+            std::size_t settled = 0;
+            for (;;) {
+                std::size_t i = next.fetch_add(1, std::memory_order_relaxed);
+                if (i >= active.size()) break;
+                settled += settle(active[i], heaps[thread], counters[thread]);
+            }
+            count.fetch_add(settled, std::memory_order_relaxed);
+        });
+        expanded += count.load();
+    }
+    this->mExpanded = expanded;
+    for (const SearchStats& counted : counters) {
+        this->mStats.pushes += counted.pushes;
+        this->mStats.stalePops += counted.stalePops;
+        this->mStats.relaxations += counted.relaxations;
+    }
+
+    // Cells inside obstacles still step out to their cheapest neighbor.
+    // Rows go to the threads in turn.
+    std::vector<Cost> largest(threads, 0);
+    onThreads(threads, [&](unsigned thread) {
+        for (int y = int(thread); y < this->mHeight; y += int(threads)) {
+            for (int x = 0; x < this->mWidth; ++x) {
+                Coordinates id{x, y};
+                int cell = grid.index(id);
+                Cost label = labels[cell].load(std::memory_order_relaxed);
+                if (!grid.passable(id) && cell != goalCell) {
+                    grid.forEachNeighbor(id, options.connectivity, options.cornerCutting,
+                                         [&](Coordinates next, int nextCell, int direction) {
+                        Cost known = labels[nextCell].load(std::memory_order_relaxed);
+                        if (known == UNREACHABLE) return;
+                        label = std::min(label, ((known >> 3) + grid.weight(next) * stepCost(id, direction)) << 3
+                                                | Cost(direction));
+                    });
+                    labels[cell].store(label, std::memory_order_relaxed);
+                }
+                if (label != UNREACHABLE) largest[thread] = std::max(largest[thread], label >> 3);
+            }
+        }
+    });
+
+    // The largest cost has to fit below UNREACHED
+    Cost top = *std::max_element(largest.begin(), largest.end());
+    this->mUnit = std::max<Cost>(1, (top + UNREACHED - 2) / (UNREACHED - 1));
+    onThreads(threads, [&](unsigned thread) {
+        std::size_t begin = cellCount * thread / threads, end = cellCount * (thread + 1) / threads;
+        for (std::size_t cell = begin; cell < end; ++cell) {
+            Cost label = labels[cell].load(std::memory_order_relaxed);
+            if (label == UNREACHABLE) continue;
+            this->costs[cell] = static_cast<std::uint16_t>((label >> 3) / this->mUnit);
+            if (int(cell) != goalCell) this->directions[cell] = static_cast<std::uint8_t>(label & 7);
+        }
+    });
+    timer.lap(this->mStats.searchUs);
+}
+
+SearchResult FlowField::path(const WeightedGrid& grid, Coordinates start, SearchTrace* trace) const {
+    SearchResult result;
+    PhaseTimer timer;
+    if (trace) trace->clear();
+    if (!grid.inBounds(start) || !grid.inBounds(this->mGoal) || !reachable(grid.index(start))) return result;
+    Cost total = 0;
+    Coordinates id = start;
+    result.path.push_back(id);
+    // A shortest path visits no cell twice, a walk that gets stuck or
+    // runs longer than that never arrives
+    while (id != this->mGoal && result.path.size() <= this->costs.size()) {
+        Coordinates next = this->next(id);
+        if (next == id) break;
+        total += grid.cost(id, next);
+        id = next;
+        result.path.push_back(id);
+    }
+    if (id != this->mGoal) {
+        result.path.clear();
+        return result;
+    }
+    if (trace) {
+        for (Coordinates step : result.path)
+            trace->path(grid.index(step));
+    }
+    result.cost = double(total) / COST_SCALE;
+    timer.lap(result.stats.pathUs);
+    return result;
+}
@@ -0,0 +1,258 @@
+#include "frontier.h"
+
+#include <algorithm>
+#include <functional>
+
+void BucketQueue::reset(std::size_t) {
+    // Down to a size that held the last query four times over, once the
+    // ring was too large for SHRINK_AFTER queries in a row. Searches of
+    // varying spread would otherwise shrink and regrow it every time.
+    std::size_t size = MIN_BUCKETS;
+    while (size < MAX_BUCKETS && size <= 4 * this->widest) size *= 2;
+    this->oversized = size < this->buckets.size() ? this->oversized + 1 : 0;
+    if (this->oversized >= SHRINK_AFTER) {
+        this->oversized = 0;
+        this->buckets.resize(size);
+        this->buckets.shrink_to_fit();
+        this->occupied.assign(size / 64, 0);
+        for (auto& bucket : this->buckets) bucket.clear();
+    } else if (this->buckets.empty()) {
+        this->buckets.resize(size);
+        this->occupied.assign(size / 64, 0);
+    } else if (this->count > 0) {
+        // Only the occupied buckets
+        for (std::size_t word = 0; word < this->occupied.size(); ++word) {
+            for (std::uint64_t bits = this->occupied[word]; bits; bits &= bits - 1)
+                this->buckets[word * 64 + __builtin_ctzll(bits)].clear();
+            this->occupied[word] = 0;
+        }
+    }
+    this->far.clear();
+    this->limit = ~Cost(0);
+    this->base = 0;
+    this->count = 0;
+    this->widest = 0;
+}
+
+void BucketQueue::put(int item, Cost priority) {
+    if (priority >= this->limit) {
+        this->far.emplace_back(priority, item);
+        std::push_heap(this->far.begin(), this->far.end(), std::greater<>());
+        return;
+    }
+    if (this->count == 0) this->base = priority;
+    // A full size ring cannot take more spread, whatever lies past it
+    // waits in the heap without rehashing the ring
+    if (priority >= this->base && priority - this->base >= MAX_BUCKETS && this->buckets.size() == MAX_BUCKETS) {
+        this->limit = std::min(this->limit, this->base + MAX_BUCKETS);
+        this->far.emplace_back(priority, item);
+        std::push_heap(this->far.begin(), this->far.end(), std::greater<>());
+        return;
+    }
+    // Keep base the smallest priority in the ring and the spread inside it
+    if (priority < this->base || priority - this->base >= this->buckets.size()) {
+        rebuild(item, priority);
+        return;
+    }
+    this->widest = std::max(this->widest, priority - this->base);
+    insert(item, priority);
+}
+
+int BucketQueue::get(Cost& priority) {
+    if (this->count == 0) refill();
+    // First occupied bucket at or after base, wrapping around the ring
+    std::size_t words = this->occupied.size();
+    std::size_t first = this->base & mask();
+    std::size_t word = first / 64;
+    std::uint64_t bits = this->occupied[word] & (~std::uint64_t(0) << (first % 64));
+    for (std::size_t scanned = 0; bits == 0; ++scanned) {
+        word = (word + 1) % words;
+        bits = this->occupied[word];
+        // Only the low part of the first word is left after a full turn
+        if (scanned == words - 1) bits &= ~(~std::uint64_t(0) << (first % 64));
+    }
+    std::size_t i = word * 64 + __builtin_ctzll(bits);
+    priority = this->base + ((i - first) & mask());
+    this->base = priority;
+
+    std::vector<int>& bucket = this->buckets[i];
+    int item = bucket.back();
+    bucket.pop_back();
+    if (bucket.empty()) this->occupied[i / 64] &= ~(std::uint64_t(1) << (i % 64));
+    --this->count;
+    return item;
+}
+
+void BucketQueue::rebuild(int item, Cost priority) {
+    std::vector<std::pair<Cost, int>> items;
+    items.reserve(this->count + 1);
+    std::size_t first = this->base & mask();
+    Cost lowest = priority, highest = priority;
+    // Only the occupied buckets
+    for (std::size_t word = 0; word < this->occupied.size(); ++word) {
+        for (std::uint64_t bits = this->occupied[word]; bits; bits &= bits - 1) {
+            std::size_t i = word * 64 + __builtin_ctzll(bits);
+            Cost key = this->base + ((i - first) & mask());
+            for (int queued : this->buckets[i]) items.emplace_back(key, queued);
+            lowest = std::min(lowest, key);
+            highest = std::max(highest, key);
+            this->buckets[i].clear();
+        }
+    }
+    items.emplace_back(priority, item);
+    std::size_t size = this->buckets.size();
+    while (size <= highest - lowest && size < MAX_BUCKETS) size *= 2;
+    if (size != this->buckets.size()) this->buckets.resize(size);
+    this->occupied.assign(size / 64, 0);
+    this->base = lowest;
+    this->count = 0;
+    this->widest = std::max(this->widest, std::min<Cost>(highest - lowest, size - 1));
+    // Past the ring everything overflows into the heap, leaving the
+    // smallest priorities in the ring
+    Cost end = lowest + size;
+    for (const auto& entry : items) {
+        if (entry.first < end) {
+            insert(entry.second, entry.first);
+        } else {
+            this->far.push_back(entry);
+            std::push_heap(this->far.begin(), this->far.end(), std::greater<>());
+            this->limit = std::min(this->limit, end);
+        }
+    }
+}
+
+void BucketQueue::refill() {
+    // Everything below one ring width from the smallest far priority
+    this->base = this->far.front().first;
+    Cost end = this->base + this->buckets.size();
+    while (!this->far.empty() && this->far.front().first < end) {
+        insert(this->far.front().second, this->far.front().first);
+        std::pop_heap(this->far.begin(), this->far.end(), std::greater<>());
+        this->far.pop_back();
+    }
+    this->limit = this->far.empty() ? ~Cost(0) : end;
+}
+
+void RadixHeap::reset(std::size_t) {
+    if (this->count > 0) {
+        for (auto& bucket : this->buckets) bucket.clear();
+    }
+    this->last = 0;
+    this->count = 0;
+}
+
+void RadixHeap::put(int item, Cost priority) {
+    this->buckets[bucket(priority)].emplace_back(priority, item);
+    ++this->count;
+}
+
+int RadixHeap::get(Cost& priority) {
+    if (this->buckets[0].empty()) {
+        // Move the first non-empty bucket down, relative to its minimum
+        std::size_t i = 1;
+        while (this->buckets[i].empty()) ++i;
+        auto& source = this->buckets[i];
+        this->last = std::min_element(source.begin(), source.end())->first;
+        for (const auto& entry : source)
+            this->buckets[bucket(entry.first)].push_back(entry);
+        source.clear();
+    }
+    auto entry = this->buckets[0].back();
+    this->buckets[0].pop_back();
+    --this->count;
+    priority = entry.first;
+    return entry.second;
+}
+
+template <class Priority>
+void BasicIndexedHeap<Priority>::reset(std::size_t items) {
+    if (this->stamp.size() != items) {
+        this->stamp.assign(items, 0);
+        this->position.resize(items);
+        this->generation = 0;
+    }
+    if (++this->generation == 0) {
+        std::fill(this->stamp.begin(), this->stamp.end(), 0);
+        this->generation = 1;
+    }
+    this->heap.clear();
+}
+
+template <class Priority>
+void BasicIndexedHeap<Priority>::put(int item, Priority priority) {
+    if (contains(item)) {
+        std::size_t i = this->position[item];
+        Priority old = this->heap[i].first;
+        this->heap[i].first = priority;
+        if (priority < old) siftUp(i);
+        else siftDown(i);
+        return;
+    }
+    this->stamp[item] = this->generation;
+    this->heap.emplace_back(priority, item);
+    this->position[item] = static_cast<int>(this->heap.size() - 1);
+    siftUp(this->heap.size() - 1);
+}
+
+template <class Priority>
+int BasicIndexedHeap<Priority>::get(Priority& priority) {
+    auto top = this->heap.front();
+    priority = top.first;
+    this->position[top.second] = -1;
+    auto last = this->heap.back();
+    this->heap.pop_back();
+    if (!this->heap.empty()) {
+        place(0, last);
+        siftDown(0);
+    }
+    return top.second;
+}
+
+template <class Priority>
+void BasicIndexedHeap<Priority>::remove(int item) {
+    if (!contains(item)) return;
+    std::size_t i = this->position[item];
+    this->position[item] = -1;
+    auto last = this->heap.back();
+    this->heap.pop_back();
+    if (i < this->heap.size()) {
+        Priority old = this->heap[i].first;
+        place(i, last);
+        if (last.first < old) siftUp(i);
+        else siftDown(i);
+    }
+}
+
+template <class Priority>
+void BasicIndexedHeap<Priority>::siftUp(std::size_t i) {
+    auto entry = this->heap[i];
+    while (i > 0) {
+        std::size_t parent = (i - 1) / ARITY;
+        if (!(entry < this->heap[parent])) break;
+        place(i, this->heap[parent]);
+        i = parent;
+    }
+    place(i, entry);
+}
+
+template <class Priority>
+void BasicIndexedHeap<Priority>::siftDown(std::size_t i) {
+    auto entry = this->heap[i];
+    std::size_t size = this->heap.size();
+    for (;;) {
+        std::size_t child = i * ARITY + 1;
+        if (child >= size) break;
+        std::size_t end = std::min(child + ARITY, size);
+        std::size_t best = child;
+        for (std::size_t c = child + 1; c < end; ++c) {
+            if (this->heap[c] < this->heap[best]) best = c;
+        }
+        if (!(this->heap[best] < entry)) break;
+        place(i, this->heap[best]);
+        i = best;
+    }
+    place(i, entry);
+}
+
+template class BasicIndexedHeap<Cost>;
+template class BasicIndexedHeap<std::pair<Cost, Cost>>;
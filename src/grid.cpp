@@ -1,179 +1,1093 @@
 #include "grid.h"
+#include "components.h"
+#include "dstar.h"
+#include "flowfield.h"
+#include "hpa.h"
+#include "jps.h"
+#include "landmarks.h"
+#include "pathdatabase.h"
+#include "statistics.h"
 
-Grid::Grid() {
-    initGrid(Visualizer::floor);
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <type_traits>
+
+// Versions of all grids come from one counter, so two grids edited
+// apart never end up with the same one
+static std::uint64_t newVersion() {
+    static std::atomic<std::uint64_t> next{0};
+    return ++next;
+}
+
+namespace {
+// Expansions between two looks at the cancel flag and the clock
+constexpr std::size_t LIMIT_INTERVAL = 256;
+
+// The SearchLimits of one query, the budget turned into a deadline, and
+// the expanded cell closest to the goal, where a stopped search leads.
+// Without limits the searches pay a comparison per expansion.
+class QueryLimits {
+public:
+    explicit QueryLimits(const SearchLimits& limits)
+        : cancel(limits.cancel)
+        , deadline(limits.deadline)
+        , maxExpanded(limits.maxExpanded)
+    {
+        if (limits.budget != std::chrono::steady_clock::duration::max()) {
+            auto now = std::chrono::steady_clock::now();
+            if (limits.budget < this->deadline - now) this->deadline = now + limits.budget;
+        }
+        bool timed = this->cancel || this->deadline != std::chrono::steady_clock::time_point::max();
+        this->nextCheck = timed ? 0 : this->maxExpanded;
+        this->tracking = timed || this->maxExpanded != SIZE_MAX;
+    }
+
+    // Before each expansion, with the nodes expanded so far
+    bool reached(std::size_t expanded) {
+        return expanded >= this->nextCheck && check(expanded);
+    }
+
+    // Lowest estimate to the goal wins, the cheaper cell on a tie
+    void offer(int cell, Cost estimate, Cost cost) {
+        if (!this->tracking) return;
+        if (this->cell < 0 || estimate < this->estimate || (estimate == this->estimate && cost < this->cost)) {
+            this->cell = cell;
+            this->estimate = estimate;
+            this->cost = cost;
+        }
+    }
+    int closest(int start) const { return this->cell < 0 ? start : this->cell; }
+
+private:
+    const std::atomic<bool>* cancel;
+    std::chrono::steady_clock::time_point deadline;
+    std::size_t maxExpanded, nextCheck;
+    bool tracking;
+    int cell = -1;
+    Cost estimate = 0, cost = 0;
+
+    // Out of the search loops, which only reach it every LIMIT_INTERVAL expansions
+    __attribute__((noinline)) bool check(std::size_t expanded) {
+        if (expanded >= this->maxExpanded) return true;
+        if ((this->cancel && this->cancel->load(std::memory_order_relaxed))
+                || std::chrono::steady_clock::now() >= this->deadline)
+            return true;
+        this->nextCheck = std::min(this->maxExpanded, expanded + LIMIT_INTERVAL);
+        return false;
+    }
+};
+}
+
+const char* algorithmName(Algorithm algorithm) {
+    switch (algorithm) {
+        case Algorithm::breadthFirst: return "bfs";
+        case Algorithm::dijkstra:     return "dijkstra";
+        case Algorithm::astar:        return "astar";
+        case Algorithm::jps:          return "jps";
+        case Algorithm::wavefront:    return "wavefront";
+        case Algorithm::hpa:          return "hpa";
+        case Algorithm::dstarLite:    return "dstar";
+        case Algorithm::alt:          return "alt";
+        case Algorithm::flowField:    return "flow";
+        case Algorithm::pathDatabase: return "cpd";
+        case Algorithm::anytime:      return "ara";
+    }
+    return "";
+}
+
+bool parseAlgorithm(const std::string& name, Algorithm& algorithm) {
+    for (Algorithm a : {Algorithm::breadthFirst, Algorithm::dijkstra, Algorithm::astar, Algorithm::jps,
+                        Algorithm::wavefront, Algorithm::hpa, Algorithm::dstarLite, Algorithm::alt,
+                        Algorithm::flowField, Algorithm::pathDatabase, Algorithm::anytime}) {
+        if (name == algorithmName(a)) {
+            algorithm = a;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* frontierName(Frontier frontier) {
+    switch (frontier) {
+        case Frontier::binaryHeap:  return "binary";
+        case Frontier::bucketQueue: return "bucket";
+        case Frontier::radixHeap:   return "radix";
+        case Frontier::indexedHeap: return "indexed";
+    }
+    return "";
+}
+
+bool parseFrontier(const std::string& name, Frontier& frontier) {
+    for (Frontier f : {Frontier::binaryHeap, Frontier::bucketQueue, Frontier::radixHeap, Frontier::indexedHeap}) {
+        if (name == frontierName(f)) {
+            frontier = f;
+            return true;
+        }
+    }
+    return false;
+}
+
+// The arrays only grow, so spaces can switch between the whole grid and
+// parts of it without reallocating
+void SearchSpace::reset(std::size_t cells) {
+    if (this->stamp.size() < cells) {
+        this->stamp.assign(cells, 0);
+        this->parents.resize(cells);
+        this->costs.resize(cells);
+        this->generation = 0;
+    }
+    // Stamps have to be cleared once the generation wraps around
+    if (++this->generation == 0) {
+        std::fill(this->stamp.begin(), this->stamp.end(), 0);
+        this->generation = 1;
+    }
+    this->queue.clear();
+    this->heap.clear();
+}
+
+SearchSpace& SearchSpace::backward() {
+    if (this->mBackward.empty()) this->mBackward.resize(1);
+    return this->mBackward.front();
+}
+
+const char* cornerCuttingName(CornerCutting corners) {
+    switch (corners) {
+        case CornerCutting::always:  return "always";
+        case CornerCutting::oneOpen: return "one-open";
+        case CornerCutting::never:   return "never";
+    }
+    return "";
+}
+
+bool parseCornerCutting(const std::string& name, CornerCutting& corners) {
+    for (CornerCutting c : {CornerCutting::always, CornerCutting::oneOpen, CornerCutting::never}) {
+        if (name == cornerCuttingName(c)) {
+            corners = c;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SearchSpace::resetLayers(std::size_t cells) {
+    // Layers never exceed the cell count, start over before they could wrap
+    if (this->layers.size() != cells || this->layerBase > UINT32_MAX - 2 * cells) {
+        this->layers.assign(cells, 0);
+        this->layerBase = 1;
+        return;
+    }
+    this->layerBase += static_cast<std::uint32_t>(cells);
+}
+
+Grid::Grid(int width, int height)
+    : mWidth(width)
+    , mHeight(height)
+    , mVersion(newVersion())
+    , stride(rowWords(width))
+    , bits(new std::uint64_t[bitmapWords(width, height)](), std::default_delete<std::uint64_t[]>())
+{
+    // Everything inside the border starts out passable
+    for (int y = 1; y <= height; ++y) {
+        std::uint64_t* row = this->bits.get() + std::size_t(y) * this->stride;
+        for (int x = 1; x <= width; x += 64 - x % 64) {
+            int end = std::min(width + 1, x - x % 64 + 64);
+            std::uint64_t mask = ~std::uint64_t(0) << (x % 64);
+            if (end % 64) mask &= ~(~std::uint64_t(0) << (end % 64));
+            row[x / 64] |= mask;
+        }
+    }
 }
 
-std::array<Coordinates, 4> Grid::DELTA = {
-    Coordinates{1, 0},  // East
-    Coordinates{-1, 0}, // West
-    Coordinates{0, -1}, // North
-    Coordinates{0, 1}   // South
+Grid::Grid(int width, int height, std::shared_ptr<std::uint64_t> bitmap)
+    : mWidth(width)
+    , mHeight(height)
+    , mVersion(newVersion())
+    , stride(rowWords(width))
+    , bits(std::move(bitmap))
+{}
+
+std::array<Coordinates, 8> Grid::DELTA = {
+    Coordinates{1, 0},   // East
+    Coordinates{-1, 0},  // West
+    Coordinates{0, -1},  // North
+    Coordinates{0, 1},   // South
+    Coordinates{1, -1},  // North east
+    Coordinates{-1, -1}, // North west
+    Coordinates{1, 1},   // South east
+    Coordinates{-1, 1}   // South west
 };
 
 bool Grid::inBounds(Coordinates id) const {
-    return 0 <= id.x && id.x < WIDTH && 0 <= id.y && id.y < HEIGHT;
+    return 0 <= id.x && id.x < this->mWidth && 0 <= id.y && id.y < this->mHeight;
 }
 bool Grid::passable(Coordinates id) const {
-    return this->obstacles.find(id) == this->obstacles.end();
+    std::size_t i = bitIndex(id);
+    return (this->bits.get()[i / 64] >> (i % 64)) & 1;
 }
 
 std::vector<Coordinates> Grid::neighbors(Coordinates id) const {
     std::vector<Coordinates> ret;
-
-    for (const auto& dir : this->DELTA) {
-        Coordinates next{id.x + dir.x, id.y + dir.y}; // Create delta coordinates
-        if (inBounds(next) && passable(next))
-            ret.push_back(next);
-    }
-    // Nudge directions for "prettier" paths
-    if ((id.x + id.y) % 2 == 0) { std::reverse(ret.begin(), ret.end()); }
+    forEachNeighbor(id, [&ret](Coordinates next, int, int) { ret.push_back(next); });
     return ret;
 }
 
-void Grid::initGrid(QVector<QVector<Tile*>> floor) {
-    for (const auto& row : floor) {
-        for (const auto& tile : row) {
-            if (tile->state == State::obstacle)
-                this->obstacles.insert(Coordinates{tile->y, tile->x});
-        }
+void Grid::setObstacle(Coordinates id, bool obstacle) {
+    if (!inBounds(id)) return;
+    // Copy on write if another grid still shares the bitmap
+    if (this->bits.use_count() > 1) {
+        std::size_t words = bitmapWords(this->mWidth, this->mHeight);
+        std::shared_ptr<std::uint64_t> copy(new std::uint64_t[words], std::default_delete<std::uint64_t[]>());
+        std::copy(this->bits.get(), this->bits.get() + words, copy.get());
+        this->bits = std::move(copy);
     }
+    this->jumps.reset();
+    this->mVersion = newVersion();
+    std::size_t i = bitIndex(id);
+    if (obstacle)
+        this->bits.get()[i / 64] &= ~(std::uint64_t(1) << (i % 64));
+    else
+        this->bits.get()[i / 64] |= std::uint64_t(1) << (i % 64);
+}
+
+void Grid::precomputeJumps() {
+    this->jumps = std::make_shared<const JumpTable>(*this);
 }
 
-void Grid::printPath() {
-    QVector<Coordinates> path;
-    Coordinates current = Visualizer::goalCoordinates;
-    while (current != Visualizer::startCoordinates) {
-        path.push_back(current);
-        current = this->cameFrom[current];
+// Room for every cell once, so tracing does not reallocate mid-search
+void Grid::beginTrace(SearchTrace& trace) const {
+    trace.clear();
+    trace.reserve(std::size_t(cellCount()) + 1);
+}
+void Grid::endTrace(SearchTrace& trace, const std::vector<Coordinates>& path) const {
+    for (Coordinates id : path)
+        trace.path(index(id));
+}
+
+// Walk the parents back from the goal, returns start ... goal. A parent
+// further away on a straight line (a jump) gets the cells between filled in.
+std::vector<Coordinates> Grid::reconstructPath(const SearchSpace& space, int start, int goal) const {
+    std::vector<Coordinates> path;
+    int current = goal;
+    while (current != start) {
+        Coordinates id = coordinates(current), parent = coordinates(space.parent(current));
+        Coordinates step{(parent.x > id.x) - (parent.x < id.x), (parent.y > id.y) - (parent.y < id.y)};
+        for (; id != parent; id.x += step.x, id.y += step.y)
+            path.push_back(id);
+        current = space.parent(current);
     }
-    Visualizer::setTile(Visualizer::goalCoordinates, State::goal);
-    auto rit = path.rbegin();
-    for (; rit != path.rend(); ++rit) {
-        Visualizer::dispatchToMainThread([=]{
-            Visualizer::setTile(*rit, State::path);
+    path.push_back(coordinates(start));
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+void Grid::stopAt(SearchResult& result, const SearchSpace& space, int start, int cell, SearchTrace* trace) const {
+    result.path = reconstructPath(space, start, cell);
+    result.partial = true;
+    if (trace) endTrace(*trace, result.path);
+}
+
+std::vector<Coordinates> Grid::joinPaths(SearchSpace& space, int start, int meet, int goal) const {
+    std::vector<Coordinates> path = reconstructPath(space, start, meet);
+    std::vector<Coordinates> rest = reconstructPath(space.backward(), goal, meet);
+    path.insert(path.end(), rest.rbegin() + 1, rest.rend());
+    return path;
+}
+
+SearchResult Grid::breadthFirstSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                      SearchTrace* trace, const SearchOptions& options) const {
+    if (options.bidirectional) return bidirectionalBreadthFirst(space, start, goal, trace, options);
+    SearchResult result;
+    if (!inBounds(start) || !inBounds(goal)) return result;
+    int startCell = index(start), goalCell = index(goal);
+    if (trace) beginTrace(*trace);
+
+    // The queue is a plain vector, every cell is pushed at most once
+    PhaseTimer timer;
+    QueryLimits limit(options.limits);
+    space.reset(cellCount());
+    std::vector<int>& frontier = space.queue;
+    frontier.push_back(startCell);
+    space.reach(startCell, startCell);
+    if constexpr (SEARCH_STATS) ++result.stats.pushes;
+    timer.lap(result.stats.setupUs);
+
+    for (std::size_t head = 0; head < frontier.size(); ++head) {
+        int current = frontier[head];
+        if (limit.reached(result.expanded)) {
+            timer.lap(result.stats.searchUs);
+            stopAt(result, space, startCell, limit.closest(startCell), trace);
+            timer.lap(result.stats.pathUs);
+            result.cost = static_cast<double>(result.path.size() - 1);
+            return result;
+        }
+        ++result.expanded;
+        limit.offer(current, heuristic(coordinates(current), goal, options.connectivity), 0);
+
+        if (current == goalCell) {
+            timer.lap(result.stats.searchUs);
+            result.path = reconstructPath(space, startCell, goalCell);
+            timer.lap(result.stats.pathUs);
+            if (trace) endTrace(*trace, result.path);
+            result.cost = static_cast<double>(result.path.size() - 1);
+            return result;
+        }
+
+        forEachNeighbor(coordinates(current), options.connectivity, options.cornerCutting,
+                        [&](Coordinates, int nextCell, int) {
+            if (!space.reached(nextCell)) {
+                frontier.push_back(nextCell);
+                space.reach(nextCell, current);
+                if constexpr (SEARCH_STATS) {
+                    ++result.stats.pushes;
+                    ++result.stats.relaxations;
+                }
+                if (trace) trace->visit(nextCell);
+            }
         });
-        QThread::usleep(10000);
     }
+    timer.lap(result.stats.searchUs);
+    return result;
 }
 
-void Grid::breadthFirstSearch() {
-    this->obstacles.clear();
-    initGrid(Visualizer::floor);
-    std::queue<Coordinates> frontier;
-    frontier.push(Visualizer::startCoordinates);
+// Both halves grow a whole layer at a time, the smaller one first. The
+// shortest meeting found while a layer grows is a shortest path, any
+// other one would have met in an earlier layer. Steps go both ways, but
+// nothing steps into an obstacle, so only the start may be one.
+SearchResult Grid::bidirectionalBreadthFirst(SearchSpace& space, Coordinates start, Coordinates goal,
+                                             SearchTrace* trace, const SearchOptions& options) const {
+    SearchResult result;
+    if (!inBounds(start) || !inBounds(goal)) return result;
+    int startCell = index(start), goalCell = index(goal);
+    if (trace) beginTrace(*trace);
+    if (startCell != goalCell && !passable(goal)) return result;
 
-    this->cameFrom[Visualizer::startCoordinates] = Visualizer::startCoordinates;
+    PhaseTimer timer;
+    QueryLimits limit(options.limits);
+    SearchSpace& back = space.backward();
+    space.reset(cellCount());
+    back.reset(cellCount());
+    space.queue.push_back(startCell);
+    space.reach(startCell, startCell);
+    back.queue.push_back(goalCell);
+    back.reach(goalCell, goalCell);
+    if constexpr (SEARCH_STATS) result.stats.pushes += 2;
+    timer.lap(result.stats.setupUs);
 
-    while (!frontier.empty()) {
-        Coordinates current = frontier.front();
-        frontier.pop();
-
-        if (current == Visualizer::goalCoordinates) {
-            printPath();
-            break;
-        }
-
-        for (Coordinates next : this->neighbors(current)) {
-            if (this->cameFrom.find(next) == this->cameFrom.end()) {
-                frontier.push(next);
-                this->cameFrom[next] = current;
-                Visualizer::dispatchToMainThread([=]{
-                    Visualizer::setTile(next, State::visited);
-                });
-                QThread::msleep(5);
+    // Cost holds the steps from the own end
+    std::size_t forwardHead = 0, backwardHead = 0;
+    Cost best = ~Cost(0);
+    int meet = startCell == goalCell ? startCell : -1;
+    bool stopped = false;
+    while (meet < 0 && !stopped && forwardHead < space.queue.size() && backwardHead < back.queue.size()) {
+        bool forward = space.queue.size() - forwardHead <= back.queue.size() - backwardHead;
+        SearchSpace& own = forward ? space : back;
+        const SearchSpace& other = forward ? back : space;
+        std::size_t& head = forward ? forwardHead : backwardHead;
+        for (std::size_t end = own.queue.size(); head < end; ++head) {
+            int current = own.queue[head];
+            Cost steps = own.cost(current) + 1;
+            // A meeting found before the rest of its layer is partial
+            if (limit.reached(result.expanded)) {
+                stopped = true;
+                break;
             }
+            ++result.expanded;
+            if (forward) limit.offer(current, heuristic(coordinates(current), goal, options.connectivity), 0);
+            forEachNeighbor(coordinates(current), options.connectivity, options.cornerCutting,
+                            [&](Coordinates, int nextCell, int) {
+                if (!own.reached(nextCell)) {
+                    own.queue.push_back(nextCell);
+                    own.reach(nextCell, current, steps);
+                    if constexpr (SEARCH_STATS) {
+                        ++result.stats.pushes;
+                        ++result.stats.relaxations;
+                    }
+                    if (trace) trace->visit(nextCell);
+                }
+                if (other.reached(nextCell) && own.cost(nextCell) + other.cost(nextCell) < best) {
+                    best = own.cost(nextCell) + other.cost(nextCell);
+                    meet = nextCell;
+                }
+            });
         }
     }
-    this->cameFrom.clear();
-    this->obstacles.clear();
-    Visualizer::setTile(Visualizer::goalCoordinates, State::goal);
+    timer.lap(result.stats.searchUs);
+    if (stopped && meet < 0) {
+        stopAt(result, space, startCell, limit.closest(startCell), trace);
+        timer.lap(result.stats.pathUs);
+        result.cost = static_cast<double>(result.path.size() - 1);
+        return result;
+    }
+    if (meet < 0) return result;
+    result.path = joinPaths(space, startCell, meet, goalCell);
+    result.partial = stopped;
+    timer.lap(result.stats.pathUs);
+    if (trace) endTrace(*trace, result.path);
+    result.cost = static_cast<double>(result.path.size() - 1);
+    return result;
+}
+
+// Step cost policies, picked once per query by withStepCost
+namespace {
+struct NudgedCost {
+    Cost operator()(Coordinates from, int direction, int) const { return stepCost(from, direction); }
+};
+template <class Weight>
+struct TerrainCost {
+    const Weight* weights;
+    Cost operator()(Coordinates from, int direction, int nextCell) const {
+        return Cost(weights[nextCell]) * stepCost(from, direction);
+    }
+};
 }
 
-// Nudge cost function for "prettier" paths in Dijkstra and A*
-double WeightedGrid::cost(Coordinates fromNode, Coordinates toNode) const {
-    bool nudge = false;
-    int x1 = fromNode.x, y1 = fromNode.y;
-    int x2 = toNode.x, y2 = toNode.y;
-    if ((x1 + y1) % 2 == 0 && x2 != x1) nudge = true;
-    if ((x1 + y1) % 2 == 1 && y2 != y1) nudge = true;
-    return  nudge ? 1.001 : 1;
+Cost WeightedGrid::cost(Coordinates fromNode, Coordinates toNode) const {
+    // Any diagonal, vertical or horizontal direction will do
+    int direction = toNode.y == fromNode.y ? 0 : toNode.x == fromNode.x ? 2 : 4;
+    return weight(toNode) * stepCost(fromNode, direction);
 }
 
-void WeightedGrid::dijkstraSearch() {
-    clearContainers();
-    initGrid(Visualizer::floor);
-    PrioriyQueue<Coordinates, double> frontier;
-    frontier.put(Visualizer::startCoordinates, 0);
+void WeightedGrid::setWeight(Coordinates id, unsigned weight) {
+    if (!inBounds(id)) return;
+    weight = std::min(std::max(weight, 1u), 65535u);
+    std::size_t cells = std::size_t(cellCount());
+    if (!hasWeights()) {
+        if (weight == 1) return;
+        this->weights8.reset(new std::uint8_t[cells], std::default_delete<std::uint8_t[]>());
+        std::fill_n(this->weights8.get(), cells, 1);
+    }
+    if (this->weights8 && weight > 255) {
+        // Widen to 16 bits
+        std::shared_ptr<std::uint16_t> wide(new std::uint16_t[cells], std::default_delete<std::uint16_t[]>());
+        std::copy(this->weights8.get(), this->weights8.get() + cells, wide.get());
+        this->weights8.reset();
+        this->weights16 = std::move(wide);
+    }
+    // Copy on write if another grid still shares the weights
+    if (this->weights8) {
+        if (this->weights8.use_count() > 1) {
+            std::shared_ptr<std::uint8_t> copy(new std::uint8_t[cells], std::default_delete<std::uint8_t[]>());
+            std::copy(this->weights8.get(), this->weights8.get() + cells, copy.get());
+            this->weights8 = std::move(copy);
+        }
+        this->weights8.get()[index(id)] = static_cast<std::uint8_t>(weight);
+    } else {
+        if (this->weights16.use_count() > 1) {
+            std::shared_ptr<std::uint16_t> copy(new std::uint16_t[cells], std::default_delete<std::uint16_t[]>());
+            std::copy(this->weights16.get(), this->weights16.get() + cells, copy.get());
+            this->weights16 = std::move(copy);
+        }
+        this->weights16.get()[index(id)] = static_cast<std::uint16_t>(weight);
+    }
+    this->mVersion = newVersion();
+    updateHierarchy(id);
+    this->mLandmarks.reset();
+    this->mPathDatabase.reset();
+}
 
-    this->cameFrom[Visualizer::startCoordinates] = Visualizer::startCoordinates;
-    this->costSoFar[Visualizer::startCoordinates] = 0;
+unsigned WeightedGrid::weight(Coordinates id) const {
+    if (this->weights16) return this->weights16.get()[index(id)];
+    if (this->weights8) return this->weights8.get()[index(id)];
+    return 1;
+}
+
+const void* WeightedGrid::weightData() const {
+    if (this->weights16) return this->weights16.get();
+    return this->weights8.get();
+}
+
+void WeightedGrid::setWeights(std::shared_ptr<std::uint8_t> weights) {
+    this->weights16.reset();
+    this->weights8 = std::move(weights);
+    weightsChanged();
+}
+
+void WeightedGrid::setWeights(std::shared_ptr<std::uint16_t> weights) {
+    this->weights8.reset();
+    this->weights16 = std::move(weights);
+    weightsChanged();
+}
+
+void WeightedGrid::weightsChanged() {
+    this->mVersion = newVersion();
+    // Every cluster may have changed, so all of them are redone
+    if (this->hierarchy) buildHierarchy(this->hierarchy->clusterSize());
+    this->mLandmarks.reset();
+    this->mPathDatabase.reset();
+}
+
+void WeightedGrid::setObstacle(Coordinates id, bool obstacle) {
+    Grid::setObstacle(id, obstacle);
+    updateHierarchy(id);
+    this->mLandmarks.reset();
+    this->mPathDatabase.reset();
+    if (this->mComponents && inBounds(id)) {
+        // Copy on write if another grid still shares the components
+        if (this->mComponents.use_count() > 1)
+            this->mComponents = std::make_shared<Components>(*this->mComponents);
+        this->mComponents->update(*this, id);
+    }
+}
+
+void WeightedGrid::buildComponents(const SearchOptions& options) {
+    this->mComponents = std::make_shared<Components>(*this, options);
+}
+
+void WeightedGrid::buildHierarchy(int clusterSize, unsigned threads) {
+    this->hierarchy = std::make_shared<Hierarchy>(*this, clusterSize, threads);
+}
+
+void WeightedGrid::updateHierarchy(Coordinates id) {
+    if (!this->hierarchy || !inBounds(id)) return;
+    // Copy on write if another grid still shares the hierarchy
+    if (this->hierarchy.use_count() > 1)
+        this->hierarchy = std::make_shared<Hierarchy>(*this->hierarchy);
+    this->hierarchy->update(*this, id);
+}
+
+void WeightedGrid::buildLandmarks(int count, const SearchOptions& options) {
+    this->mLandmarks = std::make_shared<const Landmarks>(*this, count, options);
+}
+
+void WeightedGrid::setLandmarks(std::shared_ptr<const Landmarks> landmarks) {
+    this->mLandmarks = std::move(landmarks);
+}
+
+void WeightedGrid::buildPathDatabase(const std::vector<Coordinates>& targets, const SearchOptions& options,
+                                     unsigned threads) {
+    this->mPathDatabase = std::make_shared<const PathDatabase>(*this, targets, options, threads);
+}
+
+void WeightedGrid::setPathDatabase(std::shared_ptr<const PathDatabase> database) {
+    this->mPathDatabase = std::move(database);
+}
+
+template <class Search>
+SearchResult WeightedGrid::withStepCost(Search&& search) const {
+    if (this->weights16) return search(TerrainCost<std::uint16_t>{this->weights16.get()});
+    if (this->weights8) return search(TerrainCost<std::uint8_t>{this->weights8.get()});
+    return search(NudgedCost{});
+}
+
+// Lazy deletion: a cell is queued again when its cost drops and the
+// outdated entries are skipped when they come up. Every heuristic used
+// here is consistent, so priorities taken out never decrease and the
+// bucket queue and the radix heap apply.
+template <class Queue, class Heuristic, class Expand>
+SearchResult WeightedGrid::bestFirst(SearchSpace& space, Queue& frontier, Heuristic heuristic, Expand expand,
+                                     Coordinates start, Coordinates goal, SearchTrace* trace,
+                                     const SearchOptions& options) const {
+    SearchResult result;
+    int startCell = index(start), goalCell = index(goal);
+
+    PhaseTimer timer;
+    QueryLimits limit(options.limits);
+    space.reset(cellCount());
+    frontier.reset(std::size_t(cellCount()));
+    frontier.put(startCell, heuristic(start));
+    space.reach(startCell, startCell, 0);
+    if constexpr (SEARCH_STATS) ++result.stats.pushes;
+    timer.lap(result.stats.setupUs);
 
     while (!frontier.empty()) {
-        Coordinates current = frontier.get();
-
-        if (current == Visualizer::goalCoordinates) {
-            printPath();
-            break;
-        }
-
-        for (Coordinates next : this->neighbors(current)) {
-            double newCost = this->costSoFar[current]  +  this->cost(current, next);
-            if (this->costSoFar.find(next) == this->costSoFar.end()
-                    || newCost < this->costSoFar[next])
-            {
-                this->costSoFar[next] = newCost;
-                this->cameFrom[next] = current;
-                frontier.put(next, newCost);
-                Visualizer::dispatchToMainThread([=]{
-                    Visualizer::setTile(next, State::visited);
-                });
-                QThread::msleep(5);
+        Cost priority;
+        int current = frontier.get(priority);
+        Coordinates currentId = coordinates(current);
+        if (priority > space.cost(current) + heuristic(currentId)) {
+            if constexpr (SEARCH_STATS) ++result.stats.stalePops;
+            continue;
+        }
+        if (limit.reached(result.expanded)) {
+            timer.lap(result.stats.searchUs);
+            int closest = limit.closest(startCell);
+            stopAt(result, space, startCell, closest, trace);
+            timer.lap(result.stats.pathUs);
+            result.cost = double(space.cost(closest)) / COST_SCALE;
+            return result;
+        }
+        ++result.expanded;
+        // Dijkstra has no estimate of its own
+        limit.offer(current, ::heuristic(currentId, goal, options.connectivity), space.cost(current));
+
+        if (current == goalCell) {
+            timer.lap(result.stats.searchUs);
+            result.path = reconstructPath(space, startCell, goalCell);
+            timer.lap(result.stats.pathUs);
+            if (trace) endTrace(*trace, result.path);
+            result.cost = double(space.cost(goalCell)) / COST_SCALE;
+            return result;
+        }
+
+        expand(current, currentId, [&](Coordinates next, Cost step) {
+            int nextCell = index(next);
+            Cost newCost = space.cost(current) + step;
+            if (!space.reached(nextCell) || newCost < space.cost(nextCell)) {
+                if constexpr (SEARCH_STATS) {
+                    result.stats.reRelaxations += space.reached(nextCell);
+                    ++result.stats.relaxations;
+                    ++result.stats.pushes;
+                }
+                space.reach(nextCell, current, newCost);
+                frontier.put(nextCell, newCost + heuristic(next));
+                if (trace) trace->visit(nextCell);
             }
+        });
+    }
+    timer.lap(result.stats.searchUs);
+    return result;
+}
+
+template <class Heuristic, class Expand>
+SearchResult WeightedGrid::bestFirst(SearchSpace& space, Heuristic heuristic, Expand expand, Coordinates start,
+                                     Coordinates goal, SearchTrace* trace,
+                                     const SearchOptions& options) const {
+    if (!inBounds(start) || !inBounds(goal)) return SearchResult{};
+    if (trace) beginTrace(*trace);
+
+    switch (options.frontier) {
+        case Frontier::binaryHeap:  return bestFirst(space, space.heap, heuristic, expand, start, goal, trace, options);
+        case Frontier::bucketQueue: return bestFirst(space, space.buckets, heuristic, expand, start, goal, trace, options);
+        case Frontier::radixHeap:   return bestFirst(space, space.radix, heuristic, expand, start, goal, trace, options);
+        case Frontier::indexedHeap: return bestFirst(space, space.indexed, heuristic, expand, start, goal, trace, options);
+    }
+    return SearchResult{};
+}
+
+// Front to end bidirectional search with the average potentials of
+// Ikeda et al.: the forward half runs on (hf - hb) / 2 and the backward
+// one on its negation, where hf estimates the cost to the goal and hb
+// the one from the start. Both potentials are consistent and add up to
+// zero, so the halves may stop as soon as their smallest keys add up to
+// the best meeting found. Keys are doubled to stay integer and offset by
+// the largest estimate on the map to stay unsigned, which keeps them
+// monotone for the bucket queue and the radix heap. Without estimates,
+// i.e. for Dijkstra, they are plain costs, so the buckets stay few.
+template <class Queue, class Estimate, class StepCost>
+SearchResult WeightedGrid::bidirectional(SearchSpace& space, Queue& forward, Queue& backward, Estimate estimate,
+                                         StepCost stepCost, Coordinates start, Coordinates goal,
+                                         SearchTrace* trace, const SearchOptions& options) const {
+    SearchResult result;
+    SearchSpace& back = space.backward();
+    int startCell = index(start), goalCell = index(goal);
+    const Cost offset = estimate(Coordinates{0, 0}, Coordinates{this->mWidth - 1, this->mHeight - 1});
+    const Cost scale = offset ? 2 : 1;
+    auto potential = [&](bool forwardHalf, Coordinates id) {
+        Cost toGoal = estimate(id, goal), fromStart = estimate(start, id);
+        return forwardHalf ? toGoal + offset - fromStart : fromStart + offset - toGoal;
+    };
+
+    PhaseTimer timer;
+    QueryLimits limit(options.limits);
+    space.reset(cellCount());
+    back.reset(cellCount());
+    forward.reset(std::size_t(cellCount()));
+    backward.reset(std::size_t(cellCount()));
+    space.reach(startCell, startCell, 0);
+    back.reach(goalCell, goalCell, 0);
+    Cost lastForward = potential(true, start), lastBackward = potential(false, goal);
+    forward.put(startCell, lastForward);
+    backward.put(goalCell, lastBackward);
+    if constexpr (SEARCH_STATS) result.stats.pushes += 2;
+    timer.lap(result.stats.setupUs);
+
+    const Cost NO_PATH = ~Cost(0);
+    Cost best = NO_PATH;
+    int meet = -1;
+    if (startCell == goalCell) {
+        best = 0;
+        meet = startCell;
+    }
+
+    // Takes one cell off a half, false once the search may stop or has to.
+    // Each half is compiled on its own.
+    bool stopped = false;
+    auto expandHalf = [&](auto half) {
+        constexpr bool forwardHalf = decltype(half)::value;
+        SearchSpace& own = forwardHalf ? space : back;
+        const SearchSpace& other = forwardHalf ? back : space;
+        Queue& queue = forwardHalf ? forward : backward;
+        Cost priority;
+        int current = queue.get(priority);
+        Coordinates currentId = coordinates(current);
+        if (priority > scale * own.cost(current) + potential(forwardHalf, currentId)) {
+            if constexpr (SEARCH_STATS) ++result.stats.stalePops;
+            return true;
+        }
+        (forwardHalf ? lastForward : lastBackward) = priority;
+        if (best != NO_PATH && lastForward + lastBackward >= scale * best + 2 * offset) return false;
+        if (limit.reached(result.expanded)) {
+            stopped = true;
+            return false;
         }
+        ++result.expanded;
+        if constexpr (forwardHalf) limit.offer(current, heuristic(currentId, goal, options.connectivity), own.cost(current));
+
+        forEachNeighbor(currentId, options.connectivity, options.cornerCutting,
+                        [&](Coordinates next, int nextCell, int direction) {
+            // Backwards the step runs from next to current, in the opposite direction
+            Cost step = forwardHalf ? stepCost(currentId, direction, nextCell)
+                                    : stepCost(next, direction ^ (direction < 4 ? 1 : 3), current);
+            Cost newCost = own.cost(current) + step;
+            if (own.reached(nextCell) && newCost >= own.cost(nextCell)) return;
+            if constexpr (SEARCH_STATS) {
+                result.stats.reRelaxations += own.reached(nextCell);
+                ++result.stats.relaxations;
+                ++result.stats.pushes;
+            }
+            own.reach(nextCell, current, newCost);
+            queue.put(nextCell, scale * newCost + potential(forwardHalf, next));
+            if (trace) trace->visit(nextCell);
+            if (other.reached(nextCell) && newCost + other.cost(nextCell) < best) {
+                best = newCost + other.cost(nextCell);
+                meet = nextCell;
+            }
+        });
+        return true;
+    };
+    // The half that is behind goes next
+    while (!forward.empty() && !backward.empty()) {
+        bool more = lastForward <= lastBackward ? expandHalf(std::true_type{}) : expandHalf(std::false_type{});
+        if (!more) break;
+    }
+    timer.lap(result.stats.searchUs);
+    if (stopped && meet < 0) {
+        int closest = limit.closest(startCell);
+        stopAt(result, space, startCell, closest, trace);
+        timer.lap(result.stats.pathUs);
+        result.cost = double(space.cost(closest)) / COST_SCALE;
+        return result;
+    }
+    if (meet < 0) return result;
+    result.path = joinPaths(space, startCell, meet, goalCell);
+    result.partial = stopped;
+    timer.lap(result.stats.pathUs);
+    if (trace) endTrace(*trace, result.path);
+    result.cost = double(best) / COST_SCALE;
+    return result;
+}
+
+template <class Estimate, class StepCost>
+SearchResult WeightedGrid::bidirectional(SearchSpace& space, Estimate estimate, StepCost stepCost,
+                                         Coordinates start, Coordinates goal, SearchTrace* trace,
+                                         const SearchOptions& options) const {
+    if (!inBounds(start) || !inBounds(goal)) return SearchResult{};
+    if (trace) beginTrace(*trace);
+    // Nothing steps into an obstacle, only the start may be one
+    if (start != goal && !passable(goal)) return SearchResult{};
+    SearchSpace& back = space.backward();
+
+    switch (options.frontier) {
+        case Frontier::binaryHeap:
+            return bidirectional(space, space.heap, back.heap, estimate, stepCost, start, goal, trace, options);
+        case Frontier::bucketQueue:
+            return bidirectional(space, space.buckets, back.buckets, estimate, stepCost, start, goal, trace, options);
+        case Frontier::radixHeap:
+            return bidirectional(space, space.radix, back.radix, estimate, stepCost, start, goal, trace, options);
+        case Frontier::indexedHeap:
+            return bidirectional(space, space.indexed, back.indexed, estimate, stepCost, start, goal, trace, options);
+    }
+    return SearchResult{};
+}
+
+// Every open neighbor with its step cost
+template <class StepCost, class Relax>
+void WeightedGrid::expandNeighbors(Coordinates id, const SearchOptions& options, StepCost stepCost,
+                                   Relax&& relax) const {
+    forEachNeighbor(id, options.connectivity, options.cornerCutting,
+                    [&](Coordinates next, int nextCell, int direction) {
+        relax(next, stepCost(id, direction, nextCell));
+    });
+}
+
+SearchResult WeightedGrid::dijkstraSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                          SearchTrace* trace, const SearchOptions& options) const {
+    auto zero = [](Coordinates) { return Cost(0); };
+    if (options.bidirectional) {
+        auto none = [](Coordinates, Coordinates) { return Cost(0); };
+        return withStepCost([&](auto stepCost) {
+            return bidirectional(space, none, stepCost, start, goal, trace, options);
+        });
     }
-    clearContainers();
-    Visualizer::setTile(Visualizer::goalCoordinates, State::goal);
+    return withStepCost([&](auto stepCost) {
+        auto expand = [this, &options, stepCost](int, Coordinates id, auto&& relax) {
+            expandNeighbors(id, options, stepCost, relax);
+        };
+        return bestFirst(space, zero, expand, start, goal, trace, options);
+    });
 }
 
-// Helper function
-inline double heuristic(const Coordinates& a, const Coordinates& b) {
-    return std::abs(b.x - a.x) + abs(b.y - a.y);
+SearchResult WeightedGrid::aStarSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                       SearchTrace* trace, const SearchOptions& options) const {
+    auto estimate = [goal, &options](Coordinates id) { return heuristic(id, goal, options.connectivity); };
+    if (options.bidirectional) {
+        auto between = [&options](Coordinates a, Coordinates b) { return heuristic(a, b, options.connectivity); };
+        return withStepCost([&](auto stepCost) {
+            return bidirectional(space, between, stepCost, start, goal, trace, options);
+        });
+    }
+    return withStepCost([&](auto stepCost) {
+        auto expand = [this, &options, stepCost](int, Coordinates id, auto&& relax) {
+            expandNeighbors(id, options, stepCost, relax);
+        };
+        return bestFirst(space, estimate, expand, start, goal, trace, options);
+    });
 }
 
-void WeightedGrid::aStarSearch() {
-    clearContainers();
-    initGrid(Visualizer::floor);
-    PrioriyQueue<Coordinates, double> frontier;
-    frontier.put(Visualizer::startCoordinates, 0);
+SearchResult WeightedGrid::jumpPointSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                           SearchTrace* trace, const SearchOptions& options) const {
+    auto manhattan = [goal](Coordinates id) { return heuristic(id, goal, Connectivity::four); };
+    const JumpTable* table = this->jumps.get();
+    auto expand = [this, &space, table, goal](int cell, Coordinates id, auto&& relax) {
+        Coordinates parent = coordinates(space.parent(cell));
+        for (int direction = 0; direction < 4; ++direction) {
+            // Go on straight or turn, never back towards the parent
+            Coordinates dir = DELTA[direction];
+            Coordinates back{parent.x - id.x, parent.y - id.y};
+            if (back.x * dir.x > 0 || back.y * dir.y > 0) continue;
 
-    this->cameFrom[Visualizer::startCoordinates] = Visualizer::startCoordinates;
-    this->costSoFar[Visualizer::startCoordinates] = 0;
+            Coordinates next = id;
+            bool found = table ? table->jump(*this, next, direction, goal)
+                               : jump(*this, next, direction, goal);
+            if (found)
+                relax(next, Cost(std::abs(next.x - id.x) + std::abs(next.y - id.y)) * COST_SCALE);
+        }
+    };
+    return bestFirst(space, manhattan, expand, start, goal, trace, options);
+}
 
-    while (!frontier.empty()) {
-        Coordinates current = frontier.get();
-
-        if (current == Visualizer::goalCoordinates) {
-            printPath();
-            break;
-        }
-
-        for (Coordinates next : this->neighbors(current)) {
-            double newCost = this->costSoFar[current] + this->cost(current, next);
-            if (this->costSoFar.find(next) == this->costSoFar.end()
-                    || newCost < this->costSoFar[next])
-            {
-                this->costSoFar[next] = newCost;
-                double priority = newCost + heuristic(next, Visualizer::goalCoordinates);
-                frontier.put(next, priority);
-                this->cameFrom[next] = current;
-                Visualizer::dispatchToMainThread([=]{
-                    Visualizer::setTile(next, State::visited);
-                });
-                QThread::msleep(5);
+SearchResult WeightedGrid::hierarchicalSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                              SearchTrace* trace) const {
+    if (!this->hierarchy) return aStarSearch(space, start, goal, trace);
+    if (!inBounds(start) || !inBounds(goal)) return SearchResult{};
+    if (trace) beginTrace(*trace);
+    SearchResult result = this->hierarchy->search(*this, space, start, goal, trace);
+    if (trace) endTrace(*trace, result.path);
+    return result;
+}
+
+// The landmark bound and the plain estimate are both consistent, so
+// their maximum is as well
+SearchResult WeightedGrid::altSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                     SearchTrace* trace, const SearchOptions& options) const {
+    const Landmarks* landmarks = this->mLandmarks.get();
+    if (!landmarks || !landmarks->covers(options)) return aStarSearch(space, start, goal, trace, options);
+    if (!inBounds(goal)) return SearchResult{};
+    int goalCell = index(goal);
+    auto estimate = [this, landmarks, goal, goalCell, &options](Coordinates id) {
+        return std::max(heuristic(id, goal, options.connectivity), landmarks->lowerBound(index(id), goalCell));
+    };
+    return withStepCost([&](auto stepCost) {
+        auto expand = [this, &options, stepCost](int, Coordinates id, auto&& relax) {
+            expandNeighbors(id, options, stepCost, relax);
+        };
+        return bestFirst(space, estimate, expand, start, goal, trace, options);
+    });
+}
+
+SearchResult WeightedGrid::databaseSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                          SearchTrace* trace, const SearchOptions& options) const {
+    const PathDatabase* database = this->mPathDatabase.get();
+    if (!database || !database->covers(options) || !inBounds(start) || !inBounds(goal)
+            || database->row(index(goal)) < 0 || (start != goal && !passable(start)))
+        return aStarSearch(space, start, goal, trace, options);
+    return database->path(*this, start, goal, trace);
+}
+
+// ARA* after Likhachev, Gordon and Thrun. A round is A* on cost plus
+// weight times the estimate, which may expand a cell before its cost is
+// final. Such a cell is not expanded again in the same round but waits
+// as inconsistent for the next one, which starts from the frontier and
+// those cells with a lower weight. A round ends once no key is below
+// the cost of the goal. Its bound is that cost over the lowest cost
+// plus estimate still waiting, no more than the weight. Closed cells
+// hold the round they were expanded in as their layer.
+//
+// The parents of the goal can lead along a costlier path than before
+// once a cell on it takes a new parent, so the cheapest path seen, each
+// time the goal gets cheaper and at the end of each round, is the one
+// returned. A larger budget then never returns a costlier path.
+template <class StepCost>
+SearchResult WeightedGrid::anytime(SearchSpace& space, StepCost stepCost, Coordinates start, Coordinates goal,
+                                   SearchTrace* trace, const SearchOptions& options) const {
+    SearchResult result;
+    int startCell = index(start), goalCell = index(goal);
+    auto estimate = [&options, goal](Coordinates id) { return heuristic(id, goal, options.connectivity); };
+    // Weights in thousandths, so keys stay integer
+    Cost weight = Cost(std::llround(std::max(1.0, options.anytimeWeight) * 1000));
+    auto key = [&](int cell, Coordinates id) { return space.cost(cell) + estimate(id) * weight / 1000; };
+    // Cost of the path the parents lead along from the goal. Parents may
+    // have got cheaper since, so it can be below the cost of the goal.
+    auto pathCost = [this](const std::vector<Coordinates>& path) {
+        Cost total = 0;
+        for (std::size_t i = 1; i < path.size(); ++i)
+            total += cost(path[i - 1], path[i]);
+        return total;
+    };
+    std::vector<Coordinates> best;
+    Cost bestCost = ~Cost(0);
+    auto offer = [&]() {
+        std::vector<Coordinates> path = reconstructPath(space, startCell, goalCell);
+        Cost total = pathCost(path);
+        if (total >= bestCost) return;
+        best = std::move(path);
+        bestCost = total;
+    };
+
+    PhaseTimer timer;
+    QueryLimits limit(options.limits);
+    space.reset(cellCount());
+    space.resetLayers(std::size_t(cellCount()));
+    IndexedHeap& open = space.indexed;
+    open.reset(std::size_t(cellCount()));
+    std::vector<int>& waiting = space.queue;
+    space.reach(startCell, startCell, 0);
+    open.put(startCell, key(startCell, start));
+    if constexpr (SEARCH_STATS) ++result.stats.pushes;
+    timer.lap(result.stats.setupUs);
+
+    std::uint32_t round = 0;
+    double bound = 0; // Of the paths found since the first round, 0 before
+    for (;;) {
+        bool stopped = false;
+        while (!open.empty() && (!space.reached(goalCell) || open.top().first < space.cost(goalCell))) {
+            if (limit.reached(result.expanded)) {
+                stopped = true;
+                break;
             }
+            Cost priority;
+            int current = open.get(priority);
+            Coordinates currentId = coordinates(current);
+            ++result.expanded;
+            limit.offer(current, estimate(currentId), space.cost(current));
+            space.setLayer(current, round);
+            expandNeighbors(currentId, options, stepCost, [&](Coordinates next, Cost step) {
+                int nextCell = index(next);
+                Cost newCost = space.cost(current) + step;
+                if (space.reached(nextCell) && newCost >= space.cost(nextCell)) return;
+                if constexpr (SEARCH_STATS) {
+                    result.stats.reRelaxations += space.reached(nextCell);
+                    ++result.stats.relaxations;
+                }
+                space.reach(nextCell, current, newCost);
+                if (trace) trace->visit(nextCell);
+                if (nextCell == goalCell) offer();
+                if (space.layerReached(nextCell) && space.layer(nextCell) == round) {
+                    waiting.push_back(nextCell);
+                } else {
+                    open.put(nextCell, key(nextCell, next));
+                    if constexpr (SEARCH_STATS) ++result.stats.pushes;
+                }
+            });
+        }
+        timer.lap(result.stats.searchUs);
+
+        if (stopped) {
+            // The cheapest path once a round has bounded it, else the
+            // path so far
+            if (bound > 0) {
+                result.path = best;
+                result.suboptimality = bound;
+                if (trace) endTrace(*trace, result.path);
+            } else if (space.reached(goalCell)) {
+                stopAt(result, space, startCell, goalCell, trace);
+            } else {
+                stopAt(result, space, startCell, limit.closest(startCell), trace);
+            }
+            result.cost = double(pathCost(result.path)) / COST_SCALE;
+            timer.lap(result.stats.pathUs);
+            return result;
+        }
+        // A round without the goal searched everything it could reach
+        if (!space.reached(goalCell)) return result;
+        offer();
+
+        // The frontier and the waiting cells get the keys of the next
+        // weight, the lowest cost plus estimate among them bounds the path
+        Cost nextWeight = std::max<Cost>(1000, weight - 500);
+        Cost lowest = ~Cost(0);
+        auto rekey = [&](int cell) {
+            Cost cost = space.cost(cell), toGoal = estimate(coordinates(cell));
+            lowest = std::min(lowest, cost + toGoal);
+            return cost + toGoal * nextWeight / 1000;
+        };
+        open.reprioritize(rekey);
+        for (int cell : waiting)
+            open.put(cell, rekey(cell));
+        if constexpr (SEARCH_STATS) result.stats.pushes += waiting.size();
+        waiting.clear();
+        // Against the cost of the goal, which later paths never exceed
+        Cost goalCost = space.cost(goalCell);
+        if (goalCost <= lowest) bound = 1;
+        else bound = std::max(1.0, std::min(weight / 1000.0, double(goalCost) / double(lowest)));
+        if (bound <= 1 || weight <= 1000) {
+            result.path = std::move(best);
+            result.cost = double(bestCost) / COST_SCALE;
+            timer.lap(result.stats.pathUs);
+            result.suboptimality = bound;
+            if (trace) endTrace(*trace, result.path);
+            return result;
+        }
+        weight = nextWeight;
+        ++round;
+        timer.lap(result.stats.setupUs);
+    }
+}
+
+SearchResult WeightedGrid::anytimeSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                         SearchTrace* trace, const SearchOptions& options) const {
+    if (!inBounds(start) || !inBounds(goal)) return SearchResult{};
+    if (trace) beginTrace(*trace);
+    return withStepCost([&](auto stepCost) {
+        return anytime(space, stepCost, start, goal, trace, options);
+    });
+}
+
+SearchResult WeightedGrid::search(SearchSpace& space, Algorithm algorithm, Coordinates start,
+                                  Coordinates goal, SearchTrace* trace,
+                                  const SearchOptions& options) const {
+    if constexpr (SEARCH_STATS) {
+        auto begin = std::chrono::steady_clock::now();
+        SearchResult result = dispatch(space, algorithm, start, goal, trace, options);
+        auto end = std::chrono::steady_clock::now();
+        searchStatistics().record(algorithm, result, std::chrono::duration<double, std::micro>(end - begin).count());
+        return result;
+    }
+    return dispatch(space, algorithm, start, goal, trace, options);
+}
+
+SearchResult WeightedGrid::dispatch(SearchSpace& space, Algorithm algorithm, Coordinates start,
+                                    Coordinates goal, SearchTrace* trace,
+                                    const SearchOptions& options) const {
+    const Components* components = this->mComponents.get();
+    if (components && components->covers(options) && inBounds(start) && inBounds(goal)
+            && !components->connected(*this, start, goal)) {
+        if (trace) trace->clear();
+        return SearchResult{};
+    }
+    switch (algorithm) {
+        case Algorithm::breadthFirst: return breadthFirstSearch(space, start, goal, trace, options);
+        case Algorithm::dijkstra:     return dijkstraSearch(space, start, goal, trace, options);
+        case Algorithm::astar:        return aStarSearch(space, start, goal, trace, options);
+        case Algorithm::jps:          return jumpPointSearch(space, start, goal, trace, options);
+        case Algorithm::wavefront:    return wavefrontSearch(space, start, goal, trace);
+        case Algorithm::hpa:          return hierarchicalSearch(space, start, goal, trace);
+        // Single plans, the point of D* Lite is to keep a DStarLite around
+        case Algorithm::dstarLite:    return DStarLite(*this, start, goal, options).plan(*this, trace);
+        case Algorithm::alt:          return altSearch(space, start, goal, trace, options);
+        // A whole field for one query, the point of a field is to share it
+        case Algorithm::flowField: {
+            FlowField field(*this, goal, options);
+            SearchResult result = field.path(*this, start, trace);
+            result.expanded = field.expanded();
+            double pathUs = result.stats.pathUs;
+            result.stats = field.stats();
+            result.stats.pathUs = pathUs;
+            return result;
         }
+        case Algorithm::pathDatabase: return databaseSearch(space, start, goal, trace, options);
+        case Algorithm::anytime:      return anytimeSearch(space, start, goal, trace, options);
     }
-    clearContainers();
-    Visualizer::setTile(Visualizer::goalCoordinates, State::goal);
+    return SearchResult{};
 }
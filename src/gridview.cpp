@@ -0,0 +1,144 @@
+#include "gridview.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Colors indexed by State
+static const QRgb PALETTE[STATE_COUNT] = {
+    qRgb(248, 248, 248), // empty
+    qRgb(0, 0, 75),      // obstacle
+    qRgb(120, 120, 150), // visited
+    qRgb(0, 255, 0),     // start
+    qRgb(255, 0, 0),     // goal
+    qRgb(255, 255, 0),   // path
+};
+// Empty cells with a weight above 1
+static const QRgb SWAMP = qRgb(150, 200, 160);
+
+GridView::GridView(QWidget *parent)
+    : QWidget(parent)
+{
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    this->frameTimer.setSingleShot(true);
+    this->frameTimer.setInterval(16);
+    connect(&this->frameTimer, &QTimer::timeout, this, [this]{ update(); });
+}
+
+void GridView::resizeMap(int width, int height) {
+    this->mWidth = width;
+    this->mHeight = height;
+    this->cells.assign(std::size_t(width) * height, State::empty);
+    this->weights.assign(std::size_t(width) * height, 1);
+    this->start = this->goal = Coordinates{-1, -1};
+    scheduleRepaint();
+}
+
+bool GridView::inBounds(Coordinates id) const {
+    return 0 <= id.x && id.x < this->mWidth && 0 <= id.y && id.y < this->mHeight;
+}
+
+void GridView::setState(Coordinates id, State state) {
+    if (!inBounds(id)) return;
+    this->cells[index(id)] = state;
+    if (state == State::start) this->start = id;
+    if (state == State::goal) this->goal = id;
+    scheduleRepaint();
+}
+
+void GridView::clearStates(std::initializer_list<State> states) {
+    bool clear[STATE_COUNT] = {};
+    for (State state : states)
+        clear[static_cast<int>(state)] = true;
+    for (State& cell : this->cells) {
+        if (clear[static_cast<int>(cell)]) cell = State::empty;
+    }
+    scheduleRepaint();
+}
+
+void GridView::setWeight(Coordinates id, uchar weight) {
+    if (!inBounds(id)) return;
+    this->weights[index(id)] = weight;
+    scheduleRepaint();
+}
+
+void GridView::clearWeights() {
+    std::fill(this->weights.begin(), this->weights.end(), 1);
+    scheduleRepaint();
+}
+
+void GridView::scheduleRepaint() {
+    if (!this->frameTimer.isActive()) this->frameTimer.start();
+}
+
+// Largest rectangle with square cells that fits the widget, centered
+QRect GridView::mapRect() const {
+    if (this->cells.empty()) return QRect();
+    double cell = std::min(double(width()) / this->mWidth, double(height()) / this->mHeight);
+    if (cell >= 1) cell = std::floor(cell);
+    int w = std::max(1, int(cell * this->mWidth)), h = std::max(1, int(cell * this->mHeight));
+    return QRect((width() - w) / 2, (height() - h) / 2, w, h);
+}
+
+void GridView::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+    QRect target = mapRect();
+    if (target.isEmpty()) return;
+
+    // Nearest neighbor sampling of the cells into a frame of the target size
+    if (this->frame.size() != target.size())
+        this->frame = QImage(target.size(), QImage::Format_RGB32);
+    std::vector<int> columns(target.width());
+    for (int x = 0; x < target.width(); ++x)
+        columns[x] = int(std::int64_t(x) * this->mWidth / target.width());
+    for (int y = 0; y < target.height(); ++y) {
+        std::size_t first = std::size_t(std::int64_t(y) * this->mHeight / target.height()) * this->mWidth;
+        const State* row = &this->cells[first];
+        const uchar* weights = &this->weights[first];
+        QRgb* pixels = reinterpret_cast<QRgb*>(this->frame.scanLine(y));
+        for (int x = 0; x < target.width(); ++x) {
+            State state = row[columns[x]];
+            pixels[x] = state == State::empty && weights[columns[x]] > 1 ? SWAMP : PALETTE[static_cast<int>(state)];
+        }
+    }
+    QPainter painter(this);
+    painter.drawImage(target.topLeft(), this->frame);
+
+    double cell = double(target.width()) / this->mWidth;
+    if (cell < 8) return;
+    // Cell borders and labels only where they are readable
+    painter.setPen(QColor(200, 200, 200));
+    for (int x = 0; x <= this->mWidth; ++x) {
+        int px = target.left() + int(x * cell);
+        painter.drawLine(px, target.top(), px, target.bottom());
+    }
+    for (int y = 0; y <= this->mHeight; ++y) {
+        int py = target.top() + int(y * cell);
+        painter.drawLine(target.left(), py, target.right(), py);
+    }
+    QFont font = painter.font();
+    font.setPixelSize(int(cell * 0.7));
+    painter.setFont(font);
+    painter.setPen(Qt::black);
+    auto label = [&](Coordinates id, State state, const QString& text) {
+        if (!inBounds(id) || this->state(id) != state) return;
+        QRectF rect(target.left() + id.x * cell, target.top() + id.y * cell, cell, cell);
+        painter.drawText(rect, Qt::AlignCenter, text);
+    };
+    label(this->start, State::start, "S");
+    label(this->goal, State::goal, "G");
+}
+
+void GridView::mousePressEvent(QMouseEvent *event) {
+    QRect target = mapRect();
+    if (!target.contains(event->pos())) return;
+    Coordinates id{int(std::int64_t(event->pos().x() - target.left()) * this->mWidth / target.width()),
+                   int(std::int64_t(event->pos().y() - target.top()) * this->mHeight / target.height())};
+    if (!inBounds(id)) return;
+    if (event->button() == Qt::RightButton)
+        emit cellRightClicked(id);
+    else
+        emit cellClicked(id);
+}
@@ -0,0 +1,332 @@
+#include "hpa.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
+Hierarchy::Hierarchy(const WeightedGrid& grid, int clusterSize, unsigned threads)
+    : size(std::clamp(clusterSize, 1, MAX_CLUSTER_SIZE))
+    , columns((grid.width() + size - 1) / size)
+    , rows((grid.height() + size - 1) / size)
+    , shift(0)
+    , clusters(std::size_t(columns) * rows)
+{
+    while ((1 << this->shift) < this->size) ++this->shift;
+
+    // Clusters only write their own entry, so they build independently
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, this->clusters.size()));
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        SearchSpace space;
+        for (;;) {
+            int cluster = next.fetch_add(1, std::memory_order_relaxed);
+            if (cluster >= int(this->clusters.size())) break;
+            build(grid, cluster, space);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool)
+        thread.join();
+}
+
+std::size_t Hierarchy::entranceCount() const {
+    std::size_t count = 0;
+    for (const Cluster& cluster : this->clusters)
+        count += cluster.cells.size();
+    return count;
+}
+
+int Hierarchy::entrance(const Cluster& cluster, int cell) const {
+    auto it = std::lower_bound(cluster.cells.begin(), cluster.cells.end(), cell);
+    return it != cluster.cells.end() && *it == cell ? int(it - cluster.cells.begin()) : -1;
+}
+
+// An edit changes the distances of its own cluster and the transitions
+// on its four borders, which the neighbors share
+void Hierarchy::update(const WeightedGrid& grid, Coordinates id) {
+    if (!grid.inBounds(id)) return;
+    int cx = id.x / this->size, cy = id.y / this->size;
+    build(grid, cy * this->columns + cx, this->scratch);
+    if (cx > 0) build(grid, cy * this->columns + cx - 1, this->scratch);
+    if (cx + 1 < this->columns) build(grid, cy * this->columns + cx + 1, this->scratch);
+    if (cy > 0) build(grid, (cy - 1) * this->columns + cx, this->scratch);
+    if (cy + 1 < this->rows) build(grid, (cy + 1) * this->columns + cx, this->scratch);
+}
+
+void Hierarchy::build(const WeightedGrid& grid, int index, SearchSpace& scratch) {
+    Cluster& cluster = this->clusters[index];
+    Coordinates corner = origin(index);
+    int x0 = corner.x, y0 = corner.y;
+    int x1 = std::min(x0 + this->size, grid.width()), y1 = std::min(y0 + this->size, grid.height());
+
+    // Transitions on each border with a neighbor. The neighbor scans the
+    // same cell pairs, so both sides agree on them.
+    std::vector<std::pair<int, std::uint8_t>> found;
+    for (int direction = 0; direction < 4; ++direction) {
+        Coordinates delta = Grid::DELTA[direction];
+        bool vertical = delta.x != 0;
+        // First cell of the border and the step along it
+        Coordinates first{delta.x > 0 ? x1 - 1 : x0, delta.y > 0 ? y1 - 1 : y0};
+        Coordinates along = vertical ? Coordinates{0, 1} : Coordinates{1, 0};
+        int length = vertical ? y1 - y0 : x1 - x0;
+        if (!grid.inBounds(Coordinates{first.x + delta.x, first.y + delta.y})) continue;
+
+        auto open = [&](int i) {
+            Coordinates inside{first.x + i * along.x, first.y + i * along.y};
+            return grid.passable(inside) && grid.passable(Coordinates{inside.x + delta.x, inside.y + delta.y});
+        };
+        auto add = [&](int i) {
+            Coordinates inside{first.x + i * along.x, first.y + i * along.y};
+            found.emplace_back(grid.index(inside), std::uint8_t(1 << direction));
+        };
+        for (int begin = 0; begin < length;) {
+            if (!open(begin)) {
+                ++begin;
+                continue;
+            }
+            int end = begin;
+            while (end < length && open(end)) ++end;
+            if (end - begin >= WIDE_ENTRANCE) {
+                add(begin);
+                add(end - 1);
+            } else {
+                add((begin + end - 1) / 2);
+            }
+            begin = end;
+        }
+    }
+    std::sort(found.begin(), found.end());
+    cluster.cells.clear();
+    cluster.exits.clear();
+    for (const auto& [cell, exit] : found) {
+        if (!cluster.cells.empty() && cluster.cells.back() == cell) {
+            cluster.exits.back() |= exit;
+        } else {
+            cluster.cells.push_back(cell);
+            cluster.exits.push_back(exit);
+        }
+    }
+
+    // Costs between the entrances, one Dijkstra over the cluster each
+    std::size_t count = cluster.cells.size();
+    cluster.distances.assign(count * count, NO_PATH);
+    for (std::size_t i = 0; i < count; ++i) {
+        explore<false>(grid, scratch, index, grid.coordinates(cluster.cells[i]), Coordinates{-1, -1}, nullptr);
+        for (std::size_t j = 0; j < count; ++j) {
+            int to = local(corner, grid.coordinates(cluster.cells[j]));
+            if (scratch.reached(to)) cluster.distances[i * count + j] = scratch.cost(to);
+        }
+    }
+}
+
+// Terrain weights read straight from the grid, so each search inside a
+// cluster is compiled for one weight type
+namespace {
+struct NoWeights {
+    unsigned operator[](int) const { return 1; }
+};
+template <class Weight>
+struct Weights {
+    const Weight* data;
+    unsigned operator[](int cell) const { return data[cell]; }
+};
+}
+
+template <bool Backward>
+std::size_t Hierarchy::explore(const WeightedGrid& grid, SearchSpace& space, int cluster, Coordinates source,
+                               Coordinates target, SearchTrace* trace) const {
+    const void* weights = grid.weightData();
+    switch (grid.weightBytes()) {
+        case 1:  return explore<Backward>(grid, space, cluster, source, target, trace,
+                                          Weights<std::uint8_t>{static_cast<const std::uint8_t*>(weights)});
+        case 2:  return explore<Backward>(grid, space, cluster, source, target, trace,
+                                          Weights<std::uint16_t>{static_cast<const std::uint16_t*>(weights)});
+        default: return explore<Backward>(grid, space, cluster, source, target, trace, NoWeights{});
+    }
+}
+
+template <bool Backward, class Weights>
+std::size_t Hierarchy::explore(const WeightedGrid& grid, SearchSpace& space, int cluster, Coordinates source,
+                               Coordinates target, SearchTrace* trace, Weights weights) const {
+    Coordinates corner = origin(cluster);
+    int x1 = std::min(corner.x + this->size, grid.width()), y1 = std::min(corner.y + this->size, grid.height());
+    const std::vector<int>& entrances = this->clusters[cluster].cells;
+    bool targeted = !Backward && target.x >= 0;
+    std::size_t pending = entrances.size();
+    auto estimate = [&](Coordinates id) {
+        if (!targeted) return Cost(0);
+        return Cost(std::abs(target.x - id.x) + std::abs(target.y - id.y)) * COST_SCALE;
+    };
+
+    std::size_t expanded = 0;
+    BucketQueue& frontier = space.buckets;
+    space.reset(std::size_t(1) << 2 * this->shift);
+    frontier.reset(std::size_t(1) << 2 * this->shift);
+    if (!targeted && pending == 0) return expanded;
+    int sourceCell = local(corner, source);
+    frontier.put(sourceCell, estimate(source));
+    space.reach(sourceCell, sourceCell, 0);
+
+    while (!frontier.empty()) {
+        Cost priority;
+        int current = frontier.get(priority);
+        Coordinates id = global(corner, current);
+        if (priority > space.cost(current) + estimate(id)) continue;
+        ++expanded;
+        int cell = grid.index(id);
+        if (targeted) {
+            if (id == target) break;
+        } else if (std::binary_search(entrances.begin(), entrances.end(), cell) && --pending == 0) {
+            break;
+        }
+
+        grid.forEachNeighbor(id, [&](Coordinates next, int nextCell, int direction) {
+            if (next.x < corner.x || next.x >= x1 || next.y < corner.y || next.y >= y1) return;
+            int to = local(corner, next);
+            // Backwards the step goes from next to id, in the opposite direction
+            Cost step = Backward ? weights[cell] * stepCost(next, direction ^ 1)
+                                 : weights[nextCell] * stepCost(id, direction);
+            Cost newCost = space.cost(current) + step;
+            if (!space.reached(to) || newCost < space.cost(to)) {
+                space.reach(to, current, newCost);
+                frontier.put(to, newCost + estimate(next));
+                if (trace) trace->visit(nextCell);
+            }
+        });
+    }
+    return expanded;
+}
+
+SearchResult Hierarchy::search(const WeightedGrid& grid, SearchSpace& space, Coordinates start, Coordinates goal,
+                               SearchTrace* trace) const {
+    SearchResult result;
+    if (start == goal) {
+        result.path.push_back(start);
+        result.expanded = 1;
+        return result;
+    }
+    if (!grid.passable(start) || !grid.passable(goal)) return result;
+    int startCell = grid.index(start), goalCell = grid.index(goal);
+    int startCluster = clusterOf(start), goalCluster = clusterOf(goal);
+    const Cluster& first = this->clusters[startCluster];
+    const Cluster& last = this->clusters[goalCluster];
+    Coordinates firstCorner = origin(startCluster), lastCorner = origin(goalCluster);
+
+    // Connect start and goal to the entrances of their clusters, and to
+    // each other if they share one
+    PhaseTimer timer;
+    std::vector<Cost> fromStart(first.cells.size(), NO_PATH), toGoal(last.cells.size(), NO_PATH);
+    Cost direct = NO_PATH;
+    if (startCluster == goalCluster) {
+        result.expanded += explore<false>(grid, space, startCluster, start, goal, trace);
+        if (space.reached(local(lastCorner, goal))) direct = space.cost(local(lastCorner, goal));
+    }
+    result.expanded += explore<false>(grid, space, startCluster, start, Coordinates{-1, -1}, trace);
+    for (std::size_t i = 0; i < first.cells.size(); ++i) {
+        int cell = local(firstCorner, grid.coordinates(first.cells[i]));
+        if (space.reached(cell)) fromStart[i] = space.cost(cell);
+    }
+    result.expanded += explore<true>(grid, space, goalCluster, goal, Coordinates{-1, -1}, trace);
+    for (std::size_t i = 0; i < last.cells.size(); ++i) {
+        int cell = local(lastCorner, grid.coordinates(last.cells[i]));
+        if (space.reached(cell)) toGoal[i] = space.cost(cell);
+    }
+
+    // A* over the entrances, indexed by their cells
+    auto estimate = [goal](Coordinates id) {
+        return Cost(std::abs(goal.x - id.x) + std::abs(goal.y - id.y)) * COST_SCALE;
+    };
+    PrioriyQueue<int, Cost>& frontier = space.heap;
+    space.reset(std::size_t(grid.cellCount()));
+    frontier.reset(std::size_t(grid.cellCount()));
+    frontier.put(startCell, estimate(start));
+    space.reach(startCell, startCell, 0);
+    if constexpr (SEARCH_STATS) ++result.stats.pushes;
+    timer.lap(result.stats.setupUs);
+    bool found = false;
+    while (!frontier.empty()) {
+        Cost priority;
+        int current = frontier.get(priority);
+        Coordinates id = grid.coordinates(current);
+        if (priority > space.cost(current) + estimate(id)) {
+            if constexpr (SEARCH_STATS) ++result.stats.stalePops;
+            continue;
+        }
+        ++result.expanded;
+        if (current == goalCell) {
+            found = true;
+            break;
+        }
+
+        auto relax = [&](int next, Cost step) {
+            Cost newCost = space.cost(current) + step;
+            if (!space.reached(next) || newCost < space.cost(next)) {
+                if constexpr (SEARCH_STATS) {
+                    result.stats.reRelaxations += space.reached(next);
+                    ++result.stats.relaxations;
+                    ++result.stats.pushes;
+                }
+                space.reach(next, current, newCost);
+                frontier.put(next, newCost + estimate(grid.coordinates(next)));
+                if (trace) trace->visit(next);
+            }
+        };
+        if (current == startCell) {
+            for (std::size_t i = 0; i < first.cells.size(); ++i) {
+                if (fromStart[i] != NO_PATH) relax(first.cells[i], fromStart[i]);
+            }
+            if (direct != NO_PATH) relax(goalCell, direct);
+        }
+        int index = clusterOf(id);
+        const Cluster& cluster = this->clusters[index];
+        int i = entrance(cluster, current);
+        if (i < 0) continue;
+        std::size_t count = cluster.cells.size();
+        for (std::size_t j = 0; j < count; ++j) {
+            Cost distance = cluster.distances[i * count + j];
+            if (distance != NO_PATH && int(j) != i) relax(cluster.cells[j], distance);
+        }
+        for (int direction = 0; direction < 4; ++direction) {
+            if (!(cluster.exits[i] >> direction & 1)) continue;
+            Coordinates next{id.x + Grid::DELTA[direction].x, id.y + Grid::DELTA[direction].y};
+            relax(grid.index(next), grid.cost(id, next));
+        }
+        if (index == goalCluster && toGoal[i] != NO_PATH) relax(goalCell, toGoal[i]);
+    }
+    timer.lap(result.stats.searchUs);
+    if (!found) return result;
+    Cost total = space.cost(goalCell);
+
+    std::vector<int> abstract;
+    for (int cell = goalCell; cell != startCell; cell = space.parent(cell))
+        abstract.push_back(cell);
+    abstract.push_back(startCell);
+    std::reverse(abstract.begin(), abstract.end());
+
+    // Refine: transitions are single steps, anything else is a search
+    // inside the cluster both ends belong to
+    result.path.push_back(start);
+    std::vector<Coordinates> segment;
+    for (std::size_t k = 1; k < abstract.size(); ++k) {
+        Coordinates from = grid.coordinates(abstract[k - 1]), to = grid.coordinates(abstract[k]);
+        int cluster = clusterOf(from);
+        if (cluster != clusterOf(to)) {
+            result.path.push_back(to);
+            continue;
+        }
+        result.expanded += explore<false>(grid, space, cluster, from, to, trace);
+        Coordinates corner = origin(cluster);
+        segment.clear();
+        for (int cell = local(corner, to); cell != local(corner, from); cell = space.parent(cell))
+            segment.push_back(global(corner, cell));
+        result.path.insert(result.path.end(), segment.rbegin(), segment.rend());
+    }
+    timer.lap(result.stats.pathUs);
+    result.cost = double(total) / COST_SCALE;
+    return result;
+}
@@ -0,0 +1,84 @@
+#include "jps.h"
+
+#include <limits>
+
+// Open cell beside the line whose neighbor diagonally behind is blocked,
+// the only way into it is through id
+static bool forced(const Grid& grid, Coordinates id, Coordinates dir) {
+    if (dir.x != 0) {
+        return (grid.passable({id.x, id.y - 1}) && !grid.passable({id.x - dir.x, id.y - 1})) ||
+               (grid.passable({id.x, id.y + 1}) && !grid.passable({id.x - dir.x, id.y + 1}));
+    }
+    return (grid.passable({id.x - 1, id.y}) && !grid.passable({id.x - 1, id.y - dir.y})) ||
+           (grid.passable({id.x + 1, id.y}) && !grid.passable({id.x + 1, id.y - dir.y}));
+}
+
+bool jump(const Grid& grid, Coordinates& id, int direction, Coordinates goal) {
+    Coordinates dir = Grid::DELTA[direction];
+    for (Coordinates next{id.x + dir.x, id.y + dir.y}; grid.passable(next);
+         next.x += dir.x, next.y += dir.y) {
+        bool found = next == goal || forced(grid, next, dir);
+        if (!found && dir.y != 0) {
+            // East and west of every cell of a vertical jump
+            Coordinates side = next;
+            found = jump(grid, side, 0, goal) || jump(grid, side, 1, goal);
+        }
+        if (found) {
+            id = next;
+            return true;
+        }
+    }
+    return false;
+}
+
+JumpTable::JumpTable(const Grid& grid)
+    : jumps(std::size_t(grid.cellCount()) * 4, 0)
+{
+    constexpr int LIMIT = std::numeric_limits<std::int16_t>::max();
+    // Entry of cell from the entry of the next cell in the same direction
+    auto fill = [&](Coordinates id, int direction) {
+        Coordinates dir = Grid::DELTA[direction];
+        Coordinates next{id.x + dir.x, id.y + dir.y};
+        int value = 0;
+        if (grid.passable(next)) {
+            int nextCell = grid.index(next);
+            bool jumpPoint = forced(grid, next, dir);
+            if (dir.y != 0)
+                jumpPoint = jumpPoint || distance(nextCell, 0) > 0 || distance(nextCell, 1) > 0;
+            int after = distance(nextCell, direction);
+            if (jumpPoint || after >= LIMIT || after <= -LIMIT) value = 1;
+            else value = after > 0 ? after + 1 : after - 1;
+        }
+        this->jumps[std::size_t(grid.index(id)) * 4 + direction] = static_cast<std::int16_t>(value);
+    };
+
+    // Every entry depends on the next cell, so scan against the direction.
+    // Vertical entries need the horizontal ones of the same cells.
+    int width = grid.width(), height = grid.height();
+    for (int y = 0; y < height; ++y) {
+        for (int x = width - 1; x >= 0; --x) fill({x, y}, 0); // East
+        for (int x = 0; x < width; ++x) fill({x, y}, 1);      // West
+    }
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) fill({x, y}, 2);      // North
+    }
+    for (int y = height - 1; y >= 0; --y) {
+        for (int x = 0; x < width; ++x) fill({x, y}, 3);      // South
+    }
+}
+
+bool JumpTable::jump(const Grid& grid, Coordinates& id, int direction, Coordinates goal) const {
+    Coordinates dir = Grid::DELTA[direction];
+    int value = distance(grid.index(id), direction);
+    int reach = value > 0 ? value : -value;
+
+    int ahead = dir.x != 0 ? (goal.x - id.x) * dir.x : (goal.y - id.y) * dir.y;
+    bool onLine = dir.x == 0 || goal.y == id.y;
+    if (onLine && 0 < ahead && ahead <= reach) {
+        id = Coordinates{id.x + dir.x * ahead, id.y + dir.y * ahead};
+        return true;
+    }
+    if (value <= 0) return false;
+    id = Coordinates{id.x + dir.x * value, id.y + dir.y * value};
+    return true;
+}
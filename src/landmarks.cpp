@@ -0,0 +1,128 @@
+#include "landmarks.h"
+
+#include <algorithm>
+#include <climits>
+
+namespace {
+constexpr Cost UNREACHABLE = ~Cost(0);
+
+// Full Dijkstra from source into distances, or with backward the costs
+// of reaching source
+void dijkstra(const WeightedGrid& grid, int source, const SearchOptions& options, bool backward,
+              std::vector<Cost>& distances, RadixHeap& heap) {
+    distances.assign(std::size_t(grid.cellCount()), UNREACHABLE);
+    heap.reset(distances.size());
+    distances[source] = 0;
+    heap.put(source, 0);
+    while (!heap.empty()) {
+        Cost cost;
+        int cell = heap.get(cost);
+        if (cost > distances[cell]) continue;
+        Coordinates id = grid.coordinates(cell);
+        grid.forEachNeighbor(id, options.connectivity, options.cornerCutting,
+                             [&](Coordinates next, int nextCell, int direction) {
+            // Backwards the step runs from next to id, in the opposite direction
+            Cost step = backward ? grid.weight(id) * stepCost(next, direction ^ (direction < 4 ? 1 : 3))
+                                 : grid.weight(next) * stepCost(id, direction);
+            if (cost + step < distances[nextCell]) {
+                distances[nextCell] = cost + step;
+                heap.put(nextCell, cost + step);
+            }
+        });
+    }
+}
+}
+
+Landmarks::Landmarks(const WeightedGrid& grid, int count, const SearchOptions& options)
+    : mWidth(grid.width())
+    , mHeight(grid.height())
+    , mOptions(options)
+{
+    std::size_t cellCount = std::size_t(grid.cellCount());
+    // Open cell closest to the middle
+    int seed = -1;
+    long long closest = LLONG_MAX;
+    for (int cell = 0; cell < grid.cellCount(); ++cell) {
+        Coordinates id = grid.coordinates(cell);
+        long long dx = 2 * id.x - this->mWidth, dy = 2 * id.y - this->mHeight;
+        if (grid.passable(id) && dx * dx + dy * dy < closest) {
+            closest = dx * dx + dy * dy;
+            seed = cell;
+        }
+    }
+
+    // Each landmark is the cell farthest from the ones before, the first
+    // one the cell farthest from the seed. Unreached cells never qualify.
+    std::vector<Cost> from, to, nearest;
+    std::vector<std::vector<std::uint16_t>> columns;
+    RadixHeap heap;
+    if (seed >= 0) dijkstra(grid, seed, options, false, nearest, heap);
+    count = std::min(count, MAX_COUNT);
+    for (int k = 0; k < count && seed >= 0; ++k) {
+        int landmark = -1;
+        Cost farthest = 0;
+        for (std::size_t cell = 0; cell < cellCount; ++cell) {
+            if (nearest[cell] != UNREACHABLE && nearest[cell] > farthest) {
+                farthest = nearest[cell];
+                landmark = int(cell);
+            }
+        }
+        if (landmark < 0) break;
+        dijkstra(grid, landmark, options, false, from, heap);
+        dijkstra(grid, landmark, options, true, to, heap);
+
+        // The largest distance has to fit below UNREACHED
+        Cost largest = 0;
+        for (std::size_t cell = 0; cell < cellCount; ++cell) {
+            if (from[cell] != UNREACHABLE) largest = std::max(largest, from[cell]);
+            if (to[cell] != UNREACHABLE) largest = std::max(largest, to[cell]);
+        }
+        Cost unit = std::max<Cost>(1, (largest + UNREACHED - 2) / (UNREACHED - 1));
+        auto quantize = [unit](Cost distance) {
+            return distance == UNREACHABLE ? UNREACHED : static_cast<std::uint16_t>(distance / unit);
+        };
+        std::vector<std::uint16_t> column(2 * cellCount);
+        for (std::size_t cell = 0; cell < cellCount; ++cell) {
+            column[2 * cell] = quantize(from[cell]);
+            column[2 * cell + 1] = quantize(to[cell]);
+            nearest[cell] = k == 0 ? from[cell] : std::min(nearest[cell], from[cell]);
+        }
+        columns.push_back(std::move(column));
+        this->cells.push_back(landmark);
+        this->units.push_back(static_cast<std::uint32_t>(unit));
+    }
+
+    // Interleave, a bound reads one row per cell
+    std::size_t row = 2 * columns.size();
+    std::shared_ptr<std::uint16_t> table(new std::uint16_t[std::max<std::size_t>(cellCount * row, 1)],
+                                         std::default_delete<std::uint16_t[]>());
+    for (std::size_t k = 0; k < columns.size(); ++k) {
+        for (std::size_t cell = 0; cell < cellCount; ++cell) {
+            table.get()[cell * row + 2 * k] = columns[k][2 * cell];
+            table.get()[cell * row + 2 * k + 1] = columns[k][2 * cell + 1];
+        }
+    }
+    this->mTable = std::move(table);
+    computeMultipliers();
+}
+
+Landmarks::Landmarks(int width, int height, const SearchOptions& options, std::vector<int> cells,
+                     std::vector<std::uint32_t> units, std::shared_ptr<const std::uint16_t> table)
+    : mWidth(width)
+    , mHeight(height)
+    , mOptions(options)
+    , cells(std::move(cells))
+    , units(std::move(units))
+    , mTable(std::move(table))
+{
+    computeMultipliers();
+}
+
+// Rounding makes a step lower a bound by up to cost + unit - 1 instead
+// of cost. Scaled by COST_SCALE / (COST_SCALE + unit) that stays below
+// cost for every step of at least COST_SCALE, and the bound consistent.
+void Landmarks::computeMultipliers() {
+    this->multipliers.clear();
+    for (std::uint32_t unit : this->units)
+        this->multipliers.push_back((std::uint64_t(unit) * COST_SCALE << 16) / (COST_SCALE + unit));
+}
@@ -1,11 +1,47 @@
 #include "visualizer.h"
+#include "mapfile.h"
 
 #include <QApplication>
 
+#include <cstdio>
+#include <exception>
+#include <memory>
+
+// Shortest-Path [map] or Shortest-Path [width height]: the map of a
+// .map or .bmap file, or an empty floor of that size, 40x20 by default
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
-    Visualizer w;
-    w.show();
+    QStringList args = a.arguments();
+    std::unique_ptr<Visualizer> w;
+    if (args.size() == 1) {
+        w = std::make_unique<Visualizer>();
+    } else if (args.size() == 2) {
+        try {
+            WeightedGrid map = loadMap(args[1].toStdString());
+            if (map.width() < 2 || map.height() < 2) {
+                std::fprintf(stderr, "%s has no room for a start and a goal\n", qPrintable(args[1]));
+                return 1;
+            }
+            w = std::make_unique<Visualizer>(map);
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "%s\n", e.what());
+            return 1;
+        }
+    } else if (args.size() == 3) {
+        // Room for the start and the goal
+        bool wide = false, high = false;
+        int width = args[1].toInt(&wide), height = args[2].toInt(&high);
+        if (!wide || !high || width < 2 || height < 2 || !Grid::validSize(width, height)) {
+            std::fprintf(stderr, "Sizes start at 2x2 cells, got %s x %s\n", qPrintable(args[1]), qPrintable(args[2]));
+            return 2;
+        }
+        w = std::make_unique<Visualizer>(width, height);
+    } else {
+        std::fprintf(stderr, "Usage: %s [map.map|map.bmap] or %s [width height]\n",
+                     qPrintable(args[0]), qPrintable(args[0]));
+        return 2;
+    }
+    w->show();
     return a.exec();
 }
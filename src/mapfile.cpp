@@ -0,0 +1,321 @@
+#include "mapfile.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("cannot open " + path);
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot stat " + path);
+    }
+    this->mSize = static_cast<std::size_t>(info.st_size);
+    if (this->mSize > 0) {
+        void* data = ::mmap(nullptr, this->mSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("cannot map " + path);
+        }
+        this->mData = static_cast<char*>(data);
+    }
+    // The mapping stays valid after closing the descriptor
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (this->mData) ::munmap(this->mData, this->mSize);
+}
+
+static bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+WeightedGrid loadMap(const std::string& path) {
+    if (endsWith(path, ".bmap")) return loadBitmap(path);
+    return loadMovingAiMap(path);
+}
+
+WeightedGrid loadMovingAiMap(const std::string& path) {
+    MappedFile file(path);
+    return parseMovingAiMap(file.data(), file.size());
+}
+
+// Next line without the line break, advances pos past it
+static std::string_view nextLine(const char* data, std::size_t size, std::size_t& pos) {
+    std::size_t begin = pos;
+    while (pos < size && data[pos] != '\n') ++pos;
+    std::size_t end = pos;
+    if (pos < size) ++pos;
+    if (end > begin && data[end - 1] == '\r') --end;
+    return std::string_view(data + begin, end - begin);
+}
+
+WeightedGrid parseMovingAiMap(const char* data, std::size_t size) {
+    std::size_t pos = 0;
+    long long width = -1, height = -1;
+    // Header: "type", "height" and "width" lines, terminated by "map"
+    while (pos < size) {
+        std::string_view line = nextLine(data, size, pos);
+        if (line == "map") break;
+        std::string key(line.substr(0, line.find(' ')));
+        std::string value(line.substr(std::min(line.size(), key.size() + 1)));
+        if (key == "height") height = std::strtoll(value.c_str(), nullptr, 10);
+        else if (key == "width") width = std::strtoll(value.c_str(), nullptr, 10);
+    }
+    if (!Grid::validSize(width, height))
+        throw std::runtime_error("map header lacks a valid width and height");
+
+    int stride = Grid::rowWords(width);
+    std::shared_ptr<std::uint64_t> bits(new std::uint64_t[Grid::bitmapWords(width, height)](),
+                                        std::default_delete<std::uint64_t[]>());
+    std::vector<Coordinates> swamps;
+    for (int y = 0; y < height; ++y) {
+        std::string_view line = nextLine(data, size, pos);
+        if (static_cast<long long>(line.size()) < width)
+            throw std::runtime_error("map row " + std::to_string(y) + " is too short");
+        std::uint64_t* row = bits.get() + std::size_t(y + 1) * stride;
+        for (int x = 0; x < width; ++x) {
+            char c = line[x];
+            if (c == '.' || c == 'G' || c == 'S')
+                row[(x + 1) / 64] |= std::uint64_t(1) << ((x + 1) % 64);
+            if (c == 'S') swamps.push_back(Coordinates{x, y});
+        }
+    }
+    WeightedGrid grid(int(width), int(height), std::move(bits));
+    for (Coordinates id : swamps)
+        grid.setWeight(id, SWAMP_WEIGHT);
+    return grid;
+}
+
+// Searches read the border and the bits past the last column of a row
+// as obstacles instead of checking bounds, so a file has to keep them so
+static bool clearBorder(const std::uint64_t* bits, int width, int height) {
+    std::size_t stride = Grid::rowWords(width);
+    const std::uint64_t* last = bits + std::size_t(height + 1) * stride;
+    for (std::size_t i = 0; i < stride; ++i) {
+        if (bits[i] || last[i]) return false;
+    }
+    std::size_t end = std::size_t(width) + 1;
+    std::uint64_t padding = ~std::uint64_t(0) << (end % 64);
+    for (int y = 1; y <= height; ++y) {
+        const std::uint64_t* row = bits + std::size_t(y) * stride;
+        if ((row[0] & 1) || (row[end / 64] & padding)) return false;
+        for (std::size_t i = end / 64 + 1; i < stride; ++i) {
+            if (row[i]) return false;
+        }
+    }
+    return true;
+}
+
+// A view into the mapping with an owner of its own. The bitmap and the
+// weights copy on write once their owner is shared, which a shared one
+// for the whole file would always be.
+template <class T>
+static std::shared_ptr<T> view(const std::shared_ptr<MappedFile>& file, char* data) {
+    return std::shared_ptr<T>(reinterpret_cast<T*>(data), [file](T*) {});
+}
+
+WeightedGrid loadBitmap(const std::string& path) {
+    auto file = std::make_shared<MappedFile>(path);
+    if (file->size() < sizeof(BitmapHeader))
+        throw std::runtime_error(path + " is too small for a bitmap header");
+
+    BitmapHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, "SPBITMAP", 8) != 0 || header.version != 1)
+        throw std::runtime_error(path + " is not a version 1 bitmap");
+    if (!Grid::validSize(header.width, header.height))
+        throw std::runtime_error(path + " has an inconsistent bitmap header");
+    int width = static_cast<int>(header.width), height = static_cast<int>(header.height);
+    if (header.stride != std::uint32_t(Grid::rowWords(width))
+            || (header.weightBytes != 0 && header.weightBytes != 1 && header.weightBytes != 2))
+        throw std::runtime_error(path + " has an inconsistent bitmap header");
+    std::size_t bitmapBytes = Grid::bitmapWords(width, height) * sizeof(std::uint64_t);
+    std::size_t weightBytes = std::size_t(width) * height * header.weightBytes;
+    if (file->size() < sizeof(header) + bitmapBytes + weightBytes)
+        throw std::runtime_error(path + " is truncated");
+
+    // Alias the mapping, the grid keeps the file mapped for its lifetime
+    char* data = file->data() + sizeof(header);
+    if (!clearBorder(reinterpret_cast<const std::uint64_t*>(data), width, height))
+        throw std::runtime_error(path + " has open cells in the border or the row padding");
+    WeightedGrid grid(width, height, view<std::uint64_t>(file, data));
+    // Weights are at least 1, a free step would break the A* estimates
+    std::size_t cells = std::size_t(width) * height;
+    if (header.weightBytes == 1) {
+        auto* weights = reinterpret_cast<std::uint8_t*>(data + bitmapBytes);
+        if (std::find(weights, weights + cells, 0) != weights + cells)
+            throw std::runtime_error(path + " has a weight of 0");
+        grid.setWeights(view<std::uint8_t>(file, data + bitmapBytes));
+    } else if (header.weightBytes == 2) {
+        auto* weights = reinterpret_cast<std::uint16_t*>(data + bitmapBytes);
+        if (std::find(weights, weights + cells, 0) != weights + cells)
+            throw std::runtime_error(path + " has a weight of 0");
+        grid.setWeights(view<std::uint16_t>(file, data + bitmapBytes));
+    }
+    return grid;
+}
+
+void saveBitmap(const WeightedGrid& grid, const std::string& path) {
+    BitmapHeader header{};
+    std::memcpy(header.magic, "SPBITMAP", 8);
+    header.version = 1;
+    header.width = static_cast<std::uint32_t>(grid.width());
+    header.height = static_cast<std::uint32_t>(grid.height());
+    header.stride = static_cast<std::uint32_t>(Grid::rowWords(grid.width()));
+    header.weightBytes = static_cast<std::uint32_t>(grid.weightBytes());
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(grid.bitmap()),
+              Grid::bitmapWords(grid.width(), grid.height()) * sizeof(std::uint64_t));
+    if (header.weightBytes)
+        out.write(static_cast<const char*>(grid.weightData()),
+                  std::size_t(grid.cellCount()) * header.weightBytes);
+    if (!out) throw std::runtime_error("cannot write " + path);
+}
+
+std::shared_ptr<const Landmarks> loadLandmarks(const std::string& path, const Grid& grid) {
+    auto file = std::make_shared<MappedFile>(path);
+    if (file->size() < sizeof(LandmarkHeader))
+        throw std::runtime_error(path + " is too small for a landmark header");
+
+    LandmarkHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, "SPLANDMK", 8) != 0 || header.version != 1)
+        throw std::runtime_error(path + " is not a version 1 landmark file");
+    if (int(header.width) != grid.width() || int(header.height) != grid.height())
+        throw std::runtime_error(path + " belongs to a map of another size");
+    if (header.connectivity > unsigned(Connectivity::eight) || header.cornerCutting > unsigned(CornerCutting::never)
+        || header.count > unsigned(Landmarks::MAX_COUNT))
+        throw std::runtime_error(path + " has an inconsistent landmark header");
+    // Each landmark takes 8 bytes plus two table entries per cell,
+    // divided so that a forged count cannot overflow
+    std::size_t count = header.count;
+    std::size_t perLandmark = 8 + std::size_t(grid.cellCount()) * 2 * sizeof(std::uint16_t);
+    if (count > (file->size() - sizeof(header)) / perLandmark)
+        throw std::runtime_error(path + " is truncated");
+
+    const char* data = file->data() + sizeof(header);
+    std::vector<int> cells(count);
+    std::vector<std::uint32_t> units(count);
+    for (std::size_t k = 0; k < count; ++k) {
+        std::uint32_t entry[2];
+        std::memcpy(entry, data + 8 * k, sizeof(entry));
+        if (entry[0] >= std::uint32_t(grid.cellCount()) || entry[1] == 0)
+            throw std::runtime_error(path + " has an inconsistent landmark");
+        cells[k] = int(entry[0]);
+        units[k] = entry[1];
+    }
+    SearchOptions options;
+    options.connectivity = Connectivity(header.connectivity);
+    options.cornerCutting = CornerCutting(header.cornerCutting);
+    // Alias the mapping, the landmarks keep the file mapped for their lifetime
+    std::shared_ptr<const std::uint16_t> table(file, reinterpret_cast<const std::uint16_t*>(data + 8 * count));
+    return std::make_shared<const Landmarks>(grid.width(), grid.height(), options, std::move(cells),
+                                             std::move(units), std::move(table));
+}
+
+void saveLandmarks(const Landmarks& landmarks, const std::string& path) {
+    LandmarkHeader header{};
+    std::memcpy(header.magic, "SPLANDMK", 8);
+    header.version = 1;
+    header.width = static_cast<std::uint32_t>(landmarks.width());
+    header.height = static_cast<std::uint32_t>(landmarks.height());
+    header.count = static_cast<std::uint32_t>(landmarks.count());
+    header.connectivity = static_cast<std::uint32_t>(landmarks.options().connectivity);
+    header.cornerCutting = static_cast<std::uint32_t>(landmarks.options().cornerCutting);
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int k = 0; k < landmarks.count(); ++k) {
+        std::uint32_t entry[2] = {static_cast<std::uint32_t>(landmarks.cell(k)), landmarks.unit(k)};
+        out.write(reinterpret_cast<const char*>(entry), sizeof(entry));
+    }
+    out.write(reinterpret_cast<const char*>(landmarks.table()), landmarks.tableSize() * sizeof(std::uint16_t));
+    if (!out) throw std::runtime_error("cannot write " + path);
+}
+
+std::shared_ptr<const PathDatabase> loadPathDatabase(const std::string& path, const Grid& grid) {
+    auto file = std::make_shared<MappedFile>(path);
+    if (file->size() < sizeof(PathDatabaseHeader))
+        throw std::runtime_error(path + " is too small for a path database header");
+
+    PathDatabaseHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, "SPPATHDB", 8) != 0 || header.version != 1)
+        throw std::runtime_error(path + " is not a version 1 path database");
+    if (int(header.width) != grid.width() || int(header.height) != grid.height())
+        throw std::runtime_error(path + " belongs to a map of another size");
+    if (header.connectivity > unsigned(Connectivity::eight) || header.cornerCutting > unsigned(CornerCutting::never)
+            || grid.width() > PathDatabase::MAX_SIDE || grid.height() > PathDatabase::MAX_SIDE)
+        throw std::runtime_error(path + " has an inconsistent path database header");
+    // Targets, offsets and runs must all lie inside the file, checked
+    // without overflowing on a forged count
+    std::size_t count = header.targets;
+    if (count > (file->size() - sizeof(header)) / 12)
+        throw std::runtime_error(path + " is truncated");
+    std::size_t offsetsAt = sizeof(header) + (4 * count + 7) / 8 * 8;
+    std::size_t runsAt = offsetsAt + 8 * (count + 1);
+    if (file->size() < runsAt || header.runs > (file->size() - runsAt) / 4)
+        throw std::runtime_error(path + " is truncated");
+
+    const char* data = file->data();
+    std::vector<int> targets(count);
+    for (std::size_t row = 0; row < count; ++row) {
+        std::uint32_t cell;
+        std::memcpy(&cell, data + sizeof(header) + 4 * row, sizeof(cell));
+        if (cell >= std::uint32_t(grid.cellCount()))
+            throw std::runtime_error(path + " has an inconsistent target");
+        targets[row] = int(cell);
+    }
+    // Alias the mapping, the database keeps the file mapped for its lifetime
+    std::shared_ptr<const std::uint64_t> offsets(file, reinterpret_cast<const std::uint64_t*>(data + offsetsAt));
+    for (std::size_t row = 0; row < count; ++row) {
+        if (offsets.get()[row] > offsets.get()[row + 1])
+            throw std::runtime_error(path + " has inconsistent row offsets");
+    }
+    if (offsets.get()[0] != 0 || offsets.get()[count] != header.runs)
+        throw std::runtime_error(path + " has inconsistent row offsets");
+    std::shared_ptr<const std::uint32_t> runs(file, reinterpret_cast<const std::uint32_t*>(data + runsAt));
+    SearchOptions options;
+    options.connectivity = Connectivity(header.connectivity);
+    options.cornerCutting = CornerCutting(header.cornerCutting);
+    return std::make_shared<const PathDatabase>(grid.width(), grid.height(), options, std::move(targets),
+                                                std::move(offsets), std::move(runs));
+}
+
+void savePathDatabase(const PathDatabase& database, const std::string& path) {
+    PathDatabaseHeader header{};
+    std::memcpy(header.magic, "SPPATHDB", 8);
+    header.version = 1;
+    header.width = static_cast<std::uint32_t>(database.width());
+    header.height = static_cast<std::uint32_t>(database.height());
+    header.targets = static_cast<std::uint32_t>(database.targetCount());
+    header.connectivity = static_cast<std::uint32_t>(database.options().connectivity);
+    header.cornerCutting = static_cast<std::uint32_t>(database.options().cornerCutting);
+    header.runs = database.runCount();
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int row = 0; row < database.targetCount(); ++row) {
+        std::uint32_t cell = static_cast<std::uint32_t>(database.target(row));
+        out.write(reinterpret_cast<const char*>(&cell), sizeof(cell));
+    }
+    if (database.targetCount() % 2) out.write("\0\0\0\0", 4);
+    out.write(reinterpret_cast<const char*>(database.offsets()), (database.targetCount() + 1) * sizeof(std::uint64_t));
+    out.write(reinterpret_cast<const char*>(database.runs()), database.runCount() * sizeof(std::uint32_t));
+    if (!out) throw std::runtime_error("cannot write " + path);
+}
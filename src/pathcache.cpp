@@ -0,0 +1,160 @@
+#include "pathcache.h"
+
+#include <iterator>
+
+bool PathCache::Key::sameSearch(const Key& other) const {
+    return this->version == other.version && this->algorithm == other.algorithm
+        && this->options.frontier == other.options.frontier
+        && this->options.connectivity == other.options.connectivity
+        && this->options.cornerCutting == other.options.cornerCutting
+        && this->options.bidirectional == other.options.bidirectional;
+}
+
+bool PathCache::Key::operator==(const Key& other) const {
+    return sameSearch(other) && this->start == other.start && this->goal == other.goal;
+}
+
+std::size_t PathCache::Hash::operator()(const Key& key) const {
+    std::uint64_t hash = key.version;
+    auto mix = [&hash](std::uint64_t value) {
+        hash ^= value + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+    };
+    mix(std::uint32_t(key.start.x) | std::uint64_t(std::uint32_t(key.start.y)) << 32);
+    mix(std::uint32_t(key.goal.x) | std::uint64_t(std::uint32_t(key.goal.y)) << 32);
+    mix(std::uint64_t(key.algorithm) | std::uint64_t(key.options.frontier) << 8
+        | std::uint64_t(key.options.connectivity) << 16 | std::uint64_t(key.options.cornerCutting) << 24
+        | std::uint64_t(key.options.bidirectional) << 32);
+    return std::size_t(hash);
+}
+
+PathCache::PathCache(std::size_t capacity, bool subPaths)
+    : mCapacity(capacity)
+    , subPaths(subPaths)
+{}
+
+SearchResult PathCache::search(const WeightedGrid& grid, SearchSpace& space, Algorithm algorithm,
+                               Coordinates start, Coordinates goal, SearchTrace* trace,
+                               const SearchOptions& options) {
+    SearchResult result;
+    if (find(grid, algorithm, start, goal, options, result, trace)) return result;
+    result = grid.search(space, algorithm, start, goal, trace, options);
+    insert(grid, algorithm, start, goal, options, result);
+    return result;
+}
+
+bool PathCache::find(const WeightedGrid& grid, Algorithm algorithm, Coordinates start, Coordinates goal,
+                     const SearchOptions& options, SearchResult& result, SearchTrace* trace) {
+    Key key{grid.version(), algorithm, start, goal, options};
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto hit = this->lookup.find(key);
+        if (hit != this->lookup.end()) {
+            this->entries.splice(this->entries.begin(), this->entries, hit->second);
+            result = hit->second->result;
+            ++this->mHits;
+        } else {
+            // A cached path from a cell through start and then goal
+            bool found = false;
+            if (this->subPaths && grid.inBounds(start) && grid.inBounds(goal)) {
+                int startCell = grid.index(start), goalCell = grid.index(goal);
+                auto range = this->through.equal_range(startCell);
+                for (auto it = range.first; it != range.second && !found; ++it) {
+                    Entry& entry = *it->second;
+                    if (!entry.key.sameSearch(key)) continue;
+                    int from = entry.positions.at(startCell);
+                    auto to = entry.positions.find(goalCell);
+                    if (to == entry.positions.end() || to->second < from) continue;
+                    result.path.assign(entry.result.path.begin() + from, entry.result.path.begin() + to->second + 1);
+                    result.cost = double(entry.costs[to->second] - entry.costs[from]) / entry.scale;
+                    this->entries.splice(this->entries.begin(), this->entries, it->second);
+                    found = true;
+                }
+            }
+            if (!found) {
+                ++this->mMisses;
+                return false;
+            }
+            ++this->mSubPathHits;
+        }
+    }
+    result.expanded = 0;
+    if (trace) {
+        trace->clear();
+        for (Coordinates id : result.path)
+            trace->path(grid.index(id));
+    }
+    return true;
+}
+
+void PathCache::insert(const WeightedGrid& grid, Algorithm algorithm, Coordinates start, Coordinates goal,
+                       const SearchOptions& options, const SearchResult& result) {
+    // Answers cut short by limits would outlive them
+    if (result.partial || result.suboptimality > 1) return;
+    Key key{grid.version(), algorithm, start, goal, options};
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->mCapacity == 0 || this->lookup.count(key)) return;
+    this->entries.push_front(Entry{key, result, {}, 1, {}});
+    Entry& entry = this->entries.front();
+    this->lookup.emplace(key, this->entries.begin());
+
+    if (this->subPaths && algorithm != Algorithm::hpa && result.path.size() > 2) {
+        // BFS, the wavefront BFS and JPS count steps, the others costs
+        bool steps = algorithm == Algorithm::breadthFirst || algorithm == Algorithm::wavefront
+                  || algorithm == Algorithm::jps;
+        entry.scale = steps ? 1 : double(COST_SCALE);
+        entry.costs.reserve(result.path.size());
+        entry.costs.push_back(0);
+        for (std::size_t i = 1; i < result.path.size(); ++i)
+            entry.costs.push_back(entry.costs.back() + (steps ? 1 : grid.cost(result.path[i - 1], result.path[i])));
+        for (std::size_t i = 0; i < result.path.size(); ++i) {
+            int cell = grid.index(result.path[i]);
+            entry.positions.emplace(cell, int(i));
+            this->through.emplace(cell, this->entries.begin());
+        }
+    }
+    while (this->entries.size() > this->mCapacity)
+        evict();
+}
+
+void PathCache::evict() {
+    auto victim = std::prev(this->entries.end());
+    for (const auto& position : victim->positions) {
+        auto range = this->through.equal_range(position.first);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == victim) {
+                this->through.erase(it);
+                break;
+            }
+        }
+    }
+    this->lookup.erase(victim->key);
+    this->entries.erase(victim);
+}
+
+void PathCache::clear() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->entries.clear();
+    this->lookup.clear();
+    this->through.clear();
+    this->mHits = this->mSubPathHits = this->mMisses = 0;
+}
+
+std::size_t PathCache::size() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->entries.size();
+}
+
+std::size_t PathCache::hits() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->mHits;
+}
+
+std::size_t PathCache::subPathHits() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->mSubPathHits;
+}
+
+std::size_t PathCache::misses() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->mMisses;
+}
@@ -0,0 +1,204 @@
+#include "pathdatabase.h"
+#include "frontier.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+constexpr Cost UNREACHABLE = ~Cost(0);
+// Every move and NONE, for the target itself
+constexpr std::uint32_t ANY = 0x80ff;
+
+// Bits of a 14 bit value spread to the even bits
+std::uint32_t spread(std::uint32_t value) {
+    value = (value | value << 8) & 0x00ff00ffu;
+    value = (value | value << 4) & 0x0f0f0f0fu;
+    value = (value | value << 2) & 0x33333333u;
+    value = (value | value << 1) & 0x55555555u;
+    return value;
+}
+
+// Z-order code, x in the even bits and y in the odd ones
+std::uint32_t zOrder(Coordinates id) {
+    return spread(std::uint32_t(id.x)) | spread(std::uint32_t(id.y)) << 1;
+}
+
+// Lowest move of a set, NONE rather than a move if the set has it
+std::uint32_t lowestMove(std::uint32_t moves) {
+    if (moves & std::uint32_t(1) << PathDatabase::NONE) return PathDatabase::NONE;
+    std::uint32_t move = 0;
+    while (!(moves >> move & 1)) ++move;
+    return move;
+}
+
+// Dijkstra backwards from target, the cost of reaching it from every cell
+void costsTo(const WeightedGrid& grid, int target, const SearchOptions& options,
+             std::vector<Cost>& distances, RadixHeap& heap) {
+    distances.assign(std::size_t(grid.cellCount()), UNREACHABLE);
+    heap.reset(distances.size());
+    distances[target] = 0;
+    heap.put(target, 0);
+    while (!heap.empty()) {
+        Cost cost;
+        int cell = heap.get(cost);
+        if (cost > distances[cell]) continue;
+        Coordinates id = grid.coordinates(cell);
+        // Nothing steps into a target inside an obstacle
+        if (!grid.passable(id)) continue;
+        grid.forEachNeighbor(id, options.connectivity, options.cornerCutting,
+                             [&](Coordinates next, int nextCell, int direction) {
+            // The step runs from next to id, in the opposite direction
+            Cost step = grid.weight(id) * stepCost(next, direction ^ (direction < 4 ? 1 : 3));
+            if (cost + step < distances[nextCell]) {
+                distances[nextCell] = cost + step;
+                heap.put(nextCell, cost + step);
+            }
+        });
+    }
+}
+}
+
+PathDatabase::PathDatabase(const WeightedGrid& grid, const std::vector<Coordinates>& targets,
+                           const SearchOptions& options, unsigned threads)
+    : mWidth(grid.width())
+    , mHeight(grid.height())
+    , mOptions(options)
+{
+    if (this->mWidth > MAX_SIDE || this->mHeight > MAX_SIDE)
+        throw std::invalid_argument("path databases take maps up to 16384 cells a side");
+    for (Coordinates id : targets) {
+        if (grid.inBounds(id) && this->rows.emplace(grid.index(id), int(this->targets.size())).second)
+            this->targets.push_back(grid.index(id));
+    }
+
+    // Open cells by code, the order of every row
+    std::vector<std::pair<std::uint32_t, int>> order;
+    for (int cell = 0; cell < grid.cellCount(); ++cell) {
+        Coordinates id = grid.coordinates(cell);
+        if (grid.passable(id)) order.emplace_back(zOrder(id), cell);
+    }
+    std::sort(order.begin(), order.end());
+
+    // A Dijkstra backwards from each target on one thread, targets go to
+    // the threads in turn
+    std::vector<std::vector<std::uint32_t>> rowRuns(this->targets.size());
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(1, this->targets.size())));
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        std::vector<Cost> distances;
+        RadixHeap heap;
+        for (;;) {
+            std::size_t row = next.fetch_add(1, std::memory_order_relaxed);
+            if (row >= this->targets.size()) break;
+            int target = this->targets[row];
+            costsTo(grid, target, options, distances, heap);
+
+            // Moves that start a shortest path, as bits, the target and
+            // cells that cannot reach it as NONE. A run keeps the moves
+            // all of its cells allow and ends where none is left.
+            auto allowed = [&](int cell) {
+                if (cell == target) return ANY;
+                if (distances[cell] == UNREACHABLE) return std::uint32_t(1) << NONE;
+                Coordinates id = grid.coordinates(cell);
+                std::uint32_t moves = 0;
+                grid.forEachNeighbor(id, options.connectivity, options.cornerCutting,
+                                     [&](Coordinates nextId, int nextCell, int direction) {
+                    if (distances[nextCell] != UNREACHABLE
+                            && distances[nextCell] + grid.weight(nextId) * stepCost(id, direction) == distances[cell])
+                        moves |= std::uint32_t(1) << direction;
+                });
+                return moves;
+            };
+            std::vector<std::uint32_t>& runs = rowRuns[row];
+            std::uint32_t moves = 0;
+            for (const auto& entry : order) {
+                std::uint32_t cellMoves = allowed(entry.second);
+                if (runs.empty() || (moves & cellMoves) == 0) {
+                    if (!runs.empty()) runs.back() |= lowestMove(moves);
+                    runs.push_back(entry.first << 4);
+                    moves = cellMoves;
+                } else {
+                    moves &= cellMoves;
+                }
+            }
+            if (!runs.empty()) runs.back() |= lowestMove(moves);
+            runs.shrink_to_fit();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool)
+        thread.join();
+
+    std::shared_ptr<std::uint64_t> offsets(new std::uint64_t[this->targets.size() + 1],
+                                           std::default_delete<std::uint64_t[]>());
+    offsets.get()[0] = 0;
+    for (std::size_t row = 0; row < rowRuns.size(); ++row)
+        offsets.get()[row + 1] = offsets.get()[row] + rowRuns[row].size();
+    std::shared_ptr<std::uint32_t> runs(new std::uint32_t[std::max<std::uint64_t>(offsets.get()[rowRuns.size()], 1)],
+                                        std::default_delete<std::uint32_t[]>());
+    for (std::size_t row = 0; row < rowRuns.size(); ++row)
+        std::copy(rowRuns[row].begin(), rowRuns[row].end(), runs.get() + offsets.get()[row]);
+    this->mOffsets = std::move(offsets);
+    this->mRuns = std::move(runs);
+}
+
+PathDatabase::PathDatabase(int width, int height, const SearchOptions& options, std::vector<int> targets,
+                           std::shared_ptr<const std::uint64_t> offsets, std::shared_ptr<const std::uint32_t> runs)
+    : mWidth(width)
+    , mHeight(height)
+    , mOptions(options)
+    , targets(std::move(targets))
+    , mOffsets(std::move(offsets))
+    , mRuns(std::move(runs))
+{
+    for (std::size_t row = 0; row < this->targets.size(); ++row)
+        this->rows.emplace(this->targets[row], int(row));
+}
+
+std::uint8_t PathDatabase::move(int row, Coordinates id) const {
+    const std::uint32_t* begin = this->mRuns.get() + this->mOffsets.get()[row];
+    const std::uint32_t* end = this->mRuns.get() + this->mOffsets.get()[row + 1];
+    // Last run starting at or before the code of id
+    const std::uint32_t* run = std::upper_bound(begin, end, zOrder(id) << 4 | NONE);
+    if (run == begin) return NONE;
+    return static_cast<std::uint8_t>(run[-1] & 15);
+}
+
+SearchResult PathDatabase::path(const WeightedGrid& grid, Coordinates start, Coordinates goal,
+                                SearchTrace* trace) const {
+    SearchResult result;
+    PhaseTimer timer;
+    if (trace) trace->clear();
+    if (!grid.inBounds(start) || !grid.inBounds(goal)) return result;
+    int row = this->row(grid.index(goal));
+    if (row < 0 || (start != goal && !grid.passable(start))) return result;
+    Cost total = 0;
+    Coordinates id = start;
+    result.path.push_back(id);
+    while (id != goal) {
+        std::uint8_t direction = move(row, id);
+        // Besides no path, moves of a broken file must not leave the map
+        Coordinates next = id;
+        if (direction < 8) next = Coordinates{id.x + Grid::DELTA[direction].x, id.y + Grid::DELTA[direction].y};
+        if (next == id || !grid.inBounds(next) || result.path.size() > std::size_t(grid.cellCount())) {
+            result.path.clear();
+            return result;
+        }
+        total += grid.cost(id, next);
+        id = next;
+        result.path.push_back(id);
+    }
+    if (trace) {
+        for (Coordinates step : result.path)
+            trace->path(grid.index(step));
+    }
+    result.cost = double(total) / COST_SCALE;
+    timer.lap(result.stats.pathUs);
+    return result;
+}
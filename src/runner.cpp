@@ -0,0 +1,313 @@
+#include "batch.h"
+#include "distancetable.h"
+#include "grid.h"
+#include "hpa.h"
+#include "landmarks.h"
+#include "mapfile.h"
+#include "pathcache.h"
+#include "scenario.h"
+#include "statistics.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+static void usage(const char* program) {
+    std::fprintf(stderr,
+        "Usage: %s <map> <scenario> [--algorithm bfs|dijkstra|astar|jps|wavefront|hpa|dstar|alt|flow|cpd|ara] [--format csv|json] [--threads n]\n"
+        "       [--frontier binary|bucket|radix|indexed] [--connectivity 4|8] [--corner-cutting always|one-open|never]\n"
+        "       [--cluster-size n] [--bidirectional] [--landmarks n] [--landmark-file path]\n"
+        "       [--components] [--cache n] [--path-database path] [--stats path]\n"
+        "       [--time-budget us] [--max-expanded n] [--ara-weight w] [--distance-table]\n"
+        "Runs every start/goal pair of a MovingAI scenario file on a .map or .bmap file.\n"
+        "--threads 0, the default, uses all cores.\n"
+        "--frontier picks the priority queue of dijkstra, astar and jps, bucket by default.\n"
+        "jps precomputes its jump table and hpa its cluster graph (clusters of 32 cells by default, up to 1024)\n"
+        "before the queries run, alt its landmark distances (8 landmarks by default, up to 64).\n"
+        "With --landmark-file alt reads them from path, or writes them there if it does not exist.\n"
+        "cpd builds a compressed path database to the goals of the scenario. With --path-database\n"
+        "it reads the database from path, or writes it there if it does not exist.\n"
+        "--connectivity 8 adds diagonal steps, MovingAI reference lengths assume corner cutting never.\n"
+        "--bidirectional searches bfs, dijkstra and astar from both ends.\n"
+        "--components labels the connected areas first, so queries between them return at once.\n"
+        "--cache keeps the last n results, repeated queries and ones along a cached path are not searched.\n"
+        "--stats writes latency and expansion histograms and search counters as JSON to path, in\n"
+        "builds configured with -DPATHSEARCH_STATS=ON.\n"
+        "--time-budget and --max-expanded stop each query of bfs, dijkstra, astar, jps, alt and ara\n"
+        "after that many microseconds or expanded nodes. A stopped query is partial, its path leads\n"
+        "towards the goal. ara is anytime weighted A*, starting at weight 3 or --ara-weight and\n"
+        "improving its path until it is shortest or the budget runs out.\n"
+        "--distance-table prints the dijkstra costs from every start to every goal of the scenario\n"
+        "instead, one search per start.\n",
+        program);
+}
+
+// A whole decimal number from min to max
+static bool parseCount(const char* text, long min, long max, int& value) {
+    char* end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < min || parsed > max) return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+struct Record {
+    std::size_t id;
+    Query query;
+    SearchResult result;
+    double latencyUs;
+};
+
+static void printCsvHeader() {
+    std::printf("id,start_x,start_y,goal_x,goal_y,algorithm,found,length,cost,reference_length,expanded,latency_us,"
+                "partial\n");
+}
+static void printCsv(const Record& r, Algorithm algorithm) {
+    std::printf("%zu,%d,%d,%d,%d,%s,%d,%zu,%.3f,%.3f,%zu,%.3f,%d\n",
+                r.id, r.query.start.x, r.query.start.y, r.query.goal.x, r.query.goal.y,
+                algorithmName(algorithm), r.result.found() ? 1 : 0,
+                r.result.path.empty() ? 0 : r.result.path.size() - 1, r.result.cost,
+                r.query.referenceLength, r.result.expanded, r.latencyUs, r.result.partial ? 1 : 0);
+}
+static void printTableCsvHeader() {
+    std::printf("source_x,source_y,target_x,target_y,found,cost\n");
+}
+static void printTableCsv(Coordinates source, Coordinates target, Cost cost) {
+    bool found = cost != DistanceTable::UNREACHABLE;
+    std::printf("%d,%d,%d,%d,%d,%.3f\n", source.x, source.y, target.x, target.y, found ? 1 : 0,
+                found ? double(cost) / COST_SCALE : 0.0);
+}
+static void printTableJson(Coordinates source, Coordinates target, Cost cost, bool first) {
+    bool found = cost != DistanceTable::UNREACHABLE;
+    std::printf("%s\n  {\"source\": [%d, %d], \"target\": [%d, %d], \"found\": %s, \"cost\": %.3f}",
+                first ? "" : ",", source.x, source.y, target.x, target.y, found ? "true" : "false",
+                found ? double(cost) / COST_SCALE : 0.0);
+}
+
+// Each cell once, sorted
+static std::vector<Coordinates> distinct(std::vector<Coordinates> cells) {
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+    return cells;
+}
+
+static void printJson(const Record& r, Algorithm algorithm, bool first) {
+    std::printf("%s\n  {\"id\": %zu, \"start\": [%d, %d], \"goal\": [%d, %d], \"algorithm\": \"%s\", "
+                "\"found\": %s, \"length\": %zu, \"cost\": %.3f, \"reference_length\": %.3f, "
+                "\"expanded\": %zu, \"latency_us\": %.3f, \"partial\": %s}",
+                first ? "" : ",",
+                r.id, r.query.start.x, r.query.start.y, r.query.goal.x, r.query.goal.y,
+                algorithmName(algorithm), r.result.found() ? "true" : "false",
+                r.result.path.empty() ? 0 : r.result.path.size() - 1, r.result.cost,
+                r.query.referenceLength, r.result.expanded, r.latencyUs, r.result.partial ? "true" : "false");
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3) {
+        usage(argv[0]);
+        return 2;
+    }
+    std::string mapPath = argv[1], scenarioPath = argv[2];
+    Algorithm algorithm = Algorithm::astar;
+    bool json = false;
+    unsigned threads = 0;
+    int clusterSize = 32;
+    int landmarkCount = 8;
+    std::string landmarkPath;
+    std::string databasePath;
+    std::string statsPath;
+    bool components = false;
+    bool distanceTable = false;
+    std::size_t cacheSize = 0;
+    SearchOptions options;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--algorithm" && i + 1 < argc) {
+            if (!parseAlgorithm(argv[++i], algorithm)) {
+                std::fprintf(stderr, "Unknown algorithm %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (arg == "--format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format != "csv" && format != "json") {
+                std::fprintf(stderr, "Unknown format %s\n", format.c_str());
+                return 2;
+            }
+            json = format == "json";
+        }
+        else if (arg == "--frontier" && i + 1 < argc) {
+            if (!parseFrontier(argv[++i], options.frontier)) {
+                std::fprintf(stderr, "Unknown frontier %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (arg == "--connectivity" && i + 1 < argc) {
+            std::string connectivity = argv[++i];
+            if (connectivity != "4" && connectivity != "8") {
+                std::fprintf(stderr, "Unknown connectivity %s\n", connectivity.c_str());
+                return 2;
+            }
+            options.connectivity = connectivity == "8" ? Connectivity::eight : Connectivity::four;
+        }
+        else if (arg == "--corner-cutting" && i + 1 < argc) {
+            if (!parseCornerCutting(argv[++i], options.cornerCutting)) {
+                std::fprintf(stderr, "Unknown corner cutting %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (arg == "--cluster-size" && i + 1 < argc) {
+            if (!parseCount(argv[++i], 1, Hierarchy::MAX_CLUSTER_SIZE, clusterSize)) {
+                std::fprintf(stderr, "--cluster-size takes sizes from 1 to %d\n", Hierarchy::MAX_CLUSTER_SIZE);
+                return 2;
+            }
+        }
+        else if (arg == "--landmarks" && i + 1 < argc) {
+            if (!parseCount(argv[++i], 1, Landmarks::MAX_COUNT, landmarkCount)) {
+                std::fprintf(stderr, "--landmarks takes counts from 1 to %d\n", Landmarks::MAX_COUNT);
+                return 2;
+            }
+        }
+        else if (arg == "--landmark-file" && i + 1 < argc) {
+            landmarkPath = argv[++i];
+        }
+        else if (arg == "--path-database" && i + 1 < argc) {
+            databasePath = argv[++i];
+        }
+        else if (arg == "--stats" && i + 1 < argc) {
+            statsPath = argv[++i];
+            if (!SEARCH_STATS) {
+                std::fprintf(stderr, "--stats needs a build configured with -DPATHSEARCH_STATS=ON\n");
+                return 2;
+            }
+        }
+        else if (arg == "--bidirectional") {
+            options.bidirectional = true;
+        }
+        else if (arg == "--distance-table") {
+            distanceTable = true;
+        }
+        else if (arg == "--components") {
+            components = true;
+        }
+        else if (arg == "--cache" && i + 1 < argc) {
+            cacheSize = static_cast<std::size_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--time-budget" && i + 1 < argc) {
+            options.limits.budget = std::chrono::microseconds(std::strtoll(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--max-expanded" && i + 1 < argc) {
+            options.limits.maxExpanded = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--ara-weight" && i + 1 < argc) {
+            options.anytimeWeight = std::atof(argv[++i]);
+            if (!(options.anytimeWeight >= 1 && options.anytimeWeight <= 1000)) {
+                std::fprintf(stderr, "--ara-weight takes weights from 1 to 1000\n");
+                return 2;
+            }
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    try {
+        WeightedGrid grid = loadMap(mapPath);
+        std::vector<Query> queries = loadScenario(scenarioPath);
+        if (distanceTable) {
+            std::vector<Coordinates> starts, goals;
+            for (const Query& query : queries) {
+                starts.push_back(query.start);
+                goals.push_back(query.goal);
+            }
+            auto begin = std::chrono::steady_clock::now();
+            DistanceTable table(grid, distinct(std::move(starts)), distinct(std::move(goals)), options, threads);
+            auto end = std::chrono::steady_clock::now();
+
+            if (json) std::printf("[");
+            else printTableCsvHeader();
+            for (std::size_t source = 0; source < table.sources().size(); ++source) {
+                for (std::size_t target = 0; target < table.targets().size(); ++target) {
+                    Coordinates from = table.sources()[source], to = table.targets()[target];
+                    if (json) printTableJson(from, to, table.cost(source, target), source == 0 && target == 0);
+                    else printTableCsv(from, to, table.cost(source, target));
+                }
+            }
+            if (json) std::printf("\n]\n");
+            std::fprintf(stderr, "%zux%zu distance table on %dx%d map, %.3f ms wall time, %zu nodes expanded\n",
+                         table.sources().size(), table.targets().size(), grid.width(), grid.height(),
+                         std::chrono::duration<double, std::milli>(end - begin).count(), table.expanded());
+            return 0;
+        }
+        if (algorithm == Algorithm::jps) grid.precomputeJumps();
+        if (algorithm == Algorithm::hpa) grid.buildHierarchy(clusterSize);
+        if (components) grid.buildComponents(options);
+        if (algorithm == Algorithm::alt) {
+            if (!landmarkPath.empty() && std::ifstream(landmarkPath)) {
+                grid.setLandmarks(loadLandmarks(landmarkPath, grid));
+                if (!grid.landmarks()->covers(options))
+                    std::fprintf(stderr, "%s has other steps than the queries, alt runs as astar\n", landmarkPath.c_str());
+            } else {
+                grid.buildLandmarks(landmarkCount, options);
+                if (!landmarkPath.empty()) saveLandmarks(*grid.landmarks(), landmarkPath);
+            }
+        }
+        if (algorithm == Algorithm::pathDatabase) {
+            if (!databasePath.empty() && std::ifstream(databasePath)) {
+                grid.setPathDatabase(loadPathDatabase(databasePath, grid));
+                if (!grid.pathDatabase()->covers(options))
+                    std::fprintf(stderr, "%s has other steps than the queries, cpd runs as astar\n", databasePath.c_str());
+            } else {
+                std::vector<Coordinates> goals;
+                for (const Query& query : queries)
+                    goals.push_back(query.goal);
+                grid.buildPathDatabase(goals, options, threads);
+                if (!databasePath.empty()) savePathDatabase(*grid.pathDatabase(), databasePath);
+            }
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        PathCache cache(cacheSize);
+        std::vector<BatchResult> results = searchBatch(grid, algorithm, queries, threads, options,
+                                                       cacheSize ? &cache : nullptr);
+        auto end = std::chrono::steady_clock::now();
+
+        if (json) std::printf("[");
+        else printCsvHeader();
+        for (std::size_t i = 0; i < queries.size(); ++i) {
+            Record record{i, queries[i], results[i].result, results[i].latencyUs};
+            if (json) printJson(record, algorithm, i == 0);
+            else printCsv(record, algorithm);
+        }
+        if (json) std::printf("\n]\n");
+
+        double wallMs = std::chrono::duration<double, std::milli>(end - begin).count();
+        std::fprintf(stderr, "%zu queries on %dx%d map, %.3f ms wall time, %.1f queries/s\n",
+                     queries.size(), grid.width(), grid.height(), wallMs,
+                     wallMs > 0 ? queries.size() * 1000.0 / wallMs : 0.0);
+        if (cacheSize)
+            std::fprintf(stderr, "%zu cache hits, %zu along cached paths\n", cache.hits(), cache.subPathHits());
+        if (!statsPath.empty()) {
+            std::ofstream out(statsPath);
+            out << searchStatistics().json();
+            if (!out) throw std::runtime_error("cannot write " + statsPath);
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include "scenario.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+std::vector<Query> loadScenario(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open " + path);
+
+    std::vector<Query> queries;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (line.empty() || line.rfind("version", 0) == 0) continue;
+
+        std::istringstream fields(line);
+        int bucket, width, height;
+        std::string map;
+        Query query;
+        if (!(fields >> bucket >> map >> width >> height
+                     >> query.start.x >> query.start.y >> query.goal.x >> query.goal.y))
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + " is not a scenario line");
+        double length;
+        if (fields >> length) query.referenceLength = length;
+        queries.push_back(query);
+    }
+    return queries;
+}
@@ -0,0 +1,176 @@
+#include "statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+// Raises value to candidate unless it is already as high
+void raise(std::atomic<std::uint64_t>& value, std::uint64_t candidate) {
+    std::uint64_t current = value.load(std::memory_order_relaxed);
+    while (candidate > current
+           && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {}
+}
+
+void add(std::atomic<std::uint64_t>& value, std::uint64_t amount) {
+    value.fetch_add(amount, std::memory_order_relaxed);
+}
+
+std::uint64_t nanoseconds(double microseconds) {
+    return microseconds > 0 ? std::uint64_t(std::llround(microseconds * 1000)) : 0;
+}
+
+// printf into the end of out
+template <class... Args>
+void append(std::string& out, const char* format, Args... args) {
+    char buffer[256];
+    int length = std::snprintf(buffer, sizeof(buffer), format, args...);
+    out.append(buffer, std::size_t(std::max(0, std::min(length, int(sizeof(buffer)) - 1))));
+}
+
+// Values of a histogram are divided by scale, e.g. nanoseconds to microseconds
+void appendHistogram(std::string& out, const Histogram& histogram, double scale) {
+    double mean = histogram.count() ? double(histogram.sum()) / double(histogram.count()) : 0;
+    append(out, "{\"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f, \"buckets\": [",
+           mean / scale, double(histogram.quantile(0.5)) / scale, double(histogram.quantile(0.9)) / scale,
+           double(histogram.quantile(0.99)) / scale, double(histogram.max()) / scale);
+    bool first = true;
+    for (int bucket = 0; bucket < Histogram::BUCKETS; ++bucket) {
+        std::uint64_t count = histogram.bucketCount(bucket);
+        if (count == 0) continue;
+        append(out, "%s[%.3f, %llu]", first ? "" : ", ", double(Histogram::lowerBound(bucket)) / scale,
+               static_cast<unsigned long long>(count));
+        first = false;
+    }
+    out += "]}";
+}
+}
+
+int Histogram::bucket(std::uint64_t value) {
+    if (value < 4) return int(value);
+    int octave = 63 - __builtin_clzll(value);
+    return 4 * (octave - 1) + int(value >> (octave - 2) & 3);
+}
+
+std::uint64_t Histogram::lowerBound(int bucket) {
+    if (bucket < 4) return std::uint64_t(bucket);
+    return std::uint64_t(4 + bucket % 4) << (bucket / 4 - 1);
+}
+
+void Histogram::add(std::uint64_t value) {
+    this->counts[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    this->mCount.fetch_add(1, std::memory_order_relaxed);
+    this->mSum.fetch_add(value, std::memory_order_relaxed);
+    raise(this->mMax, value);
+}
+
+void Histogram::clear() {
+    for (auto& count : this->counts)
+        count.store(0, std::memory_order_relaxed);
+    this->mCount.store(0, std::memory_order_relaxed);
+    this->mSum.store(0, std::memory_order_relaxed);
+    this->mMax.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::quantile(double q) const {
+    std::uint64_t total = 0;
+    for (const auto& count : this->counts)
+        total += count.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+    // Rank of the quantile, counting from 1
+    std::uint64_t rank = std::max<std::uint64_t>(1, std::uint64_t(std::ceil(q * double(total))));
+    std::uint64_t seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; ++bucket) {
+        std::uint64_t count = this->counts[bucket].load(std::memory_order_relaxed);
+        if (seen + count >= rank) {
+            // Spread evenly over the bucket
+            std::uint64_t lower = lowerBound(bucket);
+            std::uint64_t width = bucket + 1 < BUCKETS ? lowerBound(bucket + 1) - lower : lower / 4;
+            // Not above the largest value, which may lie low in its bucket
+            return std::min(max(), lower + std::uint64_t(double(width) * double(rank - seen - 1) / double(count)));
+        }
+        seen += count;
+    }
+    return max();
+}
+
+void SearchStatistics::record(Algorithm algorithm, const SearchResult& result, double latencyUs) {
+    Totals& totals = at(algorithm);
+    if (result.found()) add(totals.found, 1);
+    if (result.partial) add(totals.partial, 1);
+    add(totals.pushes, result.stats.pushes);
+    add(totals.stalePops, result.stats.stalePops);
+    add(totals.relaxations, result.stats.relaxations);
+    add(totals.reRelaxations, result.stats.reRelaxations);
+    add(totals.setupNs, nanoseconds(result.stats.setupUs));
+    add(totals.searchNs, nanoseconds(result.stats.searchUs));
+    add(totals.pathNs, nanoseconds(result.stats.pathUs));
+    totals.expanded.add(result.expanded);
+    // Last, so a query only counts once all of it is in
+    totals.latencyNs.add(nanoseconds(latencyUs));
+}
+
+void SearchStatistics::clear() {
+    for (Totals& totals : this->algorithms) {
+        for (auto* counter : {&totals.found, &totals.partial, &totals.pushes, &totals.stalePops,
+                              &totals.relaxations, &totals.reRelaxations, &totals.setupNs,
+                              &totals.searchNs, &totals.pathNs})
+            counter->store(0, std::memory_order_relaxed);
+        totals.latencyNs.clear();
+        totals.expanded.clear();
+    }
+}
+
+std::string SearchStatistics::json() const {
+    std::string out;
+    append(out, "{\"stats\": %s, \"algorithms\": {", SEARCH_STATS ? "true" : "false");
+    bool first = true;
+    for (int index = 0; index < ALGORITHMS; ++index) {
+        Algorithm algorithm = Algorithm(index);
+        const Totals& totals = at(algorithm);
+        if (queries(algorithm) == 0) continue;
+        auto load = [](const std::atomic<std::uint64_t>& value) {
+            return static_cast<unsigned long long>(value.load(std::memory_order_relaxed));
+        };
+        append(out, "%s\n  \"%s\": {\"queries\": %llu, \"found\": %llu, \"partial\": %llu, ",
+               first ? "" : ",", algorithmName(algorithm),
+               static_cast<unsigned long long>(queries(algorithm)), load(totals.found), load(totals.partial));
+        append(out, "\"pushes\": %llu, \"stale_pops\": %llu, ", load(totals.pushes), load(totals.stalePops));
+        append(out, "\"relaxations\": %llu, \"re_relaxations\": %llu, ",
+               load(totals.relaxations), load(totals.reRelaxations));
+        append(out, "\"setup_us\": %.3f, \"search_us\": %.3f, \"path_us\": %.3f,\n    \"latency_us\": ",
+               load(totals.setupNs) / 1000.0, load(totals.searchNs) / 1000.0, load(totals.pathNs) / 1000.0);
+        appendHistogram(out, totals.latencyNs, 1000);
+        out += ",\n    \"expanded\": ";
+        appendHistogram(out, totals.expanded, 1);
+        out += "}";
+        first = false;
+    }
+    out += first ? "}}\n" : "\n}}\n";
+    return out;
+}
+
+std::string SearchStatistics::summary(Algorithm algorithm) const {
+    const Totals& totals = at(algorithm);
+    std::uint64_t count = queries(algorithm);
+    std::string out;
+    append(out, "%s: %llu queries, %llu found, %llu partial\n", algorithmName(algorithm),
+           static_cast<unsigned long long>(count),
+           static_cast<unsigned long long>(totals.found.load(std::memory_order_relaxed)),
+           static_cast<unsigned long long>(totals.partial.load(std::memory_order_relaxed)));
+    if (count == 0) return out;
+    const Histogram& latency = totals.latencyNs;
+    append(out, "latency p50 %.1f p90 %.1f max %.1f us\n", latency.quantile(0.5) / 1000.0,
+           latency.quantile(0.9) / 1000.0, latency.max() / 1000.0);
+    const Histogram& expanded = totals.expanded;
+    append(out, "expanded p50 %llu p90 %llu max %llu\n",
+           static_cast<unsigned long long>(expanded.quantile(0.5)),
+           static_cast<unsigned long long>(expanded.quantile(0.9)),
+           static_cast<unsigned long long>(expanded.max()));
+    return out;
+}
+
+SearchStatistics& searchStatistics() {
+    static SearchStatistics statistics;
+    return statistics;
+}
@@ -1,174 +1,236 @@
 #include "visualizer.h"
 #include "./ui_visualizer.h"
 #include "helper.h"
+#include "mapfile.h"
+#include "statistics.h"
 
-Visualizer::Visualizer(QWidget *parent)
+#include <QFile>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <algorithm>
+
+Visualizer::Visualizer(int width, int height, QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::Visualizer)
     , algorithm(Algorithm::breadthFirst)
+    , floorGrid(width, height)
 {
     ui->setupUi(this);
-    setupFloor();
+    setupFloor(width, height);
 
     connect(&mFuturewatcher, SIGNAL(started()), this, SLOT(searchStarted()));
     connect(&mFuturewatcher, SIGNAL(finished()), this, SLOT(searchEnded()));
+
+    // One batch of trace events per frame
+    this->replayTimer.setInterval(16);
+    connect(&replayTimer, SIGNAL(timeout()), this, SLOT(replayStep()));
+}
+
+Visualizer::Visualizer(const WeightedGrid& map, QWidget *parent)
+    : Visualizer(map.width(), map.height(), parent)
+{
+    printMap(map);
+    // Start and goal on the first and the last open cell
+    int first = 0, last = map.cellCount() - 1;
+    while (first < last && !map.passable(map.coordinates(first))) ++first;
+    while (last > first && !map.passable(map.coordinates(last))) --last;
+    updateStart(map.coordinates(first));
+    updateGoal(map.coordinates(last));
 }
 
 Visualizer::~Visualizer() { delete ui; }
 
-// Deactivate all input while animating path search
+// Deactivate all input but the Search button while searching, it
+// cancels the search then. The replay can be interrupted.
 void Visualizer::searchStarted() {
-    QWidget::setEnabled(false);
+    for (QWidget* child : ui->centralwidget->findChildren<QWidget*>(QString(), Qt::FindDirectChildrenOnly))
+        child->setEnabled(child == ui->Search);
+    ui->Search->setText("Cancel (Esc)");
 }
 void Visualizer::searchEnded() {
     if (mFuturewatcher.isFinished()) {
-        QWidget::setEnabled(true);
+        for (QWidget* child : ui->centralwidget->findChildren<QWidget*>(QString(), Qt::FindDirectChildrenOnly))
+            child->setEnabled(true);
+        ui->Search->setText("Search (Enter)");
+        showStats(mFuturewatcher.result());
+        this->replayPosition = 0;
+        this->replayTimer.start();
+        replayStep();
     }
 }
 
 
-// Attempt to make GUI updates threadsafe
-void Visualizer::dispatchToMainThread(std::function<void()> callback) {
-    // Any thread
-    QTimer* timer = new QTimer();
-    timer->moveToThread(qApp->thread());
-    timer->setSingleShot(true);
-    QObject::connect(timer, &QTimer::timeout, [=]() {
-        // Main thread
-        callback();
-        timer->deleteLater();
-    });
-    QMetaObject::invokeMethod(timer, "start", Qt::QueuedConnection, Q_ARG(int, 0));
+void Visualizer::showStats(const SearchResult& result) {
+    // How far a cancelled search or ARA* got
+    QString outcome;
+    if (result.partial) outcome = "cancelled, partial path\n";
+    else if (result.suboptimality > 1) outcome = QString("within %1 of shortest\n").arg(result.suboptimality, 0, 'f', 3);
+    if (!SEARCH_STATS) {
+        ui->Stats->setPlainText(outcome + QString("expanded %1\n\nConfigure with\n-DPATHSEARCH_STATS=ON for\n"
+                                                  "counters and histograms").arg(result.expanded));
+        return;
+    }
+    const SearchStats& stats = result.stats;
+    QString text = QString("expanded %1, pushed %2\nstale pops %3\nrelaxed %4, again %5\n"
+                           "setup %6 search %7 path %8 us\n")
+                       .arg(result.expanded).arg(stats.pushes).arg(stats.stalePops)
+                       .arg(stats.relaxations).arg(stats.reRelaxations)
+                       .arg(stats.setupUs, 0, 'f', 0).arg(stats.searchUs, 0, 'f', 0).arg(stats.pathUs, 0, 'f', 0);
+    ui->Stats->setPlainText(outcome + text + QString::fromStdString(searchStatistics().summary(this->algorithm)));
+}
+void Visualizer::on_SaveStats_clicked() {
+    QString path = QFileDialog::getSaveFileName(this, "Save stats", "stats.json", "JSON (*.json)");
+    if (path.isEmpty()) return;
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)
+            || file.write(QByteArray::fromStdString(searchStatistics().json())) < 0)
+        QMessageBox::warning(this, "Save stats", "Cannot write " + path);
 }
 
-// Initialize static objects
-QVector<QVector<Tile*>> Visualizer::floor;
-Coordinates Visualizer::startCoordinates;
-Coordinates Visualizer::goalCoordinates;
+// Snapshot of the obstacles and swamps on the floor for the search library
+WeightedGrid Visualizer::gridFromFloor() const {
+    return this->floorGrid;
+}
 
-// Helper function
-bool inBounds(Coordinates id) {
-    return  0 <= id.x && id.x < WIDTH && 0 <= id.y && id.y < HEIGHT;
+// Paint the trace events up to end
+void Visualizer::replayUntil(std::size_t end) {
+    const auto& events = this->trace.events();
+    for (; this->replayPosition < end; ++this->replayPosition) {
+        const SearchTrace::Event& event = events[this->replayPosition];
+        Coordinates id{event.cell % floor->mapWidth(), event.cell / floor->mapWidth()};
+        if (id == startCoordinates || id == goalCoordinates) continue;
+        setTile(id, event.kind == SearchTrace::Kind::path ? State::path : State::visited);
+    }
 }
-void Visualizer::setTile(Coordinates id, State state) {
-    if (inBounds(id)) {
-        switch (state) {
-            case State::empty: {
-                floor[id.y][id.x]->state = State::empty;
-                floor[id.y][id.x]->setStyleSheet(EMPTY);
-                floor[id.y][id.x]->setText("");
-                break;
-            }
-            case State::obstacle: {
-                floor[id.y][id.x]->state = State::obstacle;
-                floor[id.y][id.x]->setStyleSheet(OBSTACLE);
-                floor[id.y][id.x]->setText("");
-                break;
-            }
-            case State::visited: {
-                floor[id.y][id.x]->state = State::visited;
-                floor[id.y][id.x]->setStyleSheet(VISITED);
-                break;
-            }
-            case State::path: {
-                floor[id.y][id.x]->state = State::path;
-                floor[id.y][id.x]->setStyleSheet(PATH);
-                break;
-            }
-            case State::start: {
-                floor[id.y][id.x]->state = State::start;
-                floor[id.y][id.x]->setStyleSheet(START);
-                floor[id.y][id.x]->setText("S");
-                startCoordinates = id;
-                break;
-            }
-            case State::goal: {
-                floor[id.y][id.x]->state = State::goal;
-                floor[id.y][id.x]->setStyleSheet(GOAL);
-                floor[id.y][id.x]->setText("G");
-                goalCoordinates = id;
-                break;
-            }
-            default: break;
-        }
+// Events per frame depend on the ReplaySpeed box, fast replays any
+// trace within about two seconds
+void Visualizer::replayStep() {
+    std::size_t size = this->trace.events().size();
+    std::size_t perFrame;
+    switch (ui->ReplaySpeed->currentIndex()) {
+        case 0:  perFrame = 3; break;
+        case 1:  perFrame = 12; break;
+        case 2:  perFrame = std::max<std::size_t>(200, size / 120); break;
+        default: perFrame = size; break;
     }
+    replayUntil(std::min(size, this->replayPosition + perFrame));
+    if (this->replayPosition >= size) this->replayTimer.stop();
+}
+// Skip straight to the result
+void Visualizer::finishReplay() {
+    if (!this->replayTimer.isActive()) return;
+    this->replayTimer.stop();
+    replayUntil(this->trace.events().size());
+}
+// Drop the rest of the replay, e.g. when the floor is edited
+void Visualizer::stopReplay() {
+    this->replayTimer.stop();
+    this->replayPosition = this->trace.events().size();
+}
 
+void Visualizer::setTile(Coordinates id, State state) {
+    if (!floor->inBounds(id)) return;
+    floor->setState(id, state);
+    bool obstacle = state == State::obstacle;
+    if (obstacle == this->floorGrid.passable(id)) this->floorGrid.setObstacle(id, obstacle);
+    if (state == State::start) startCoordinates = id;
+    if (state == State::goal) goalCoordinates = id;
 }
-void Visualizer::handleObstacleClick(int index) {
+void Visualizer::handleObstacleClick(Coordinates id) {
     if (searchExecuted) clearFloor();
 
-    int height = index / WIDTH;
-    int width = index % WIDTH;
-
-    if (floor[height][width]->isEmpty())
-        setTile({width, height}, State::obstacle);
-    else if (floor[height][width]->isObstacle())
-        setTile({width, height}, State::empty);
-}
-void Visualizer::setupFloor() {
-    QGridLayout* gridLayout = ui->gridLayout;
-    QSignalMapper* mapper = new QSignalMapper(this);
-
-    // i = height; j = width
-    for (int height = 0; height < HEIGHT; ++height) {
-        QVector<Tile*> row;
-        for (int width = 0; width < WIDTH; ++width) {
-            Tile* tile = new Tile(height, width, State::empty);
-            row.push_back(tile);
-            tile->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Minimum);
-            tile->setText("");
-            tile->setMinimumSize(QSize(20, 20));
-            QFont font = tile->font();
-            font.setPointSize(17);
-            tile->setFont(font);
-            gridLayout->addWidget(tile, height, width);
-            mapper->setMapping(tile, height * WIDTH + width);
-            connect(tile, SIGNAL(clicked()), mapper, SLOT(map()));
-        }
-        floor.push_back(row);
-    }
-    gridLayout->setSpacing(0);
-    connect(mapper, SIGNAL(mapped(int)), this, SLOT(handleObstacleClick(int)));
+    if (floor->state(id) == State::empty)
+        setTile(id, State::obstacle);
+    else if (floor->state(id) == State::obstacle)
+        setTile(id, State::empty);
+    if (this->planner) this->edits.push_back(id);
+}
+// Right clicks turn plain ground into swamp and back
+void Visualizer::handleSwampClick(Coordinates id) {
+    if (searchExecuted) clearFloor();
+    floor->setWeight(id, floor->weight(id) > 1 ? 1 : SWAMP_WEIGHT);
+    this->floorGrid.setWeight(id, floor->weight(id));
+    if (this->planner) this->edits.push_back(id);
+}
+void Visualizer::setupFloor(int width, int height) {
+    floor = new GridView(this);
+    floor->resizeMap(width, height);
+    ui->gridLayout->addWidget(floor, 0, 0);
+    connect(floor, &GridView::cellClicked, this, &Visualizer::handleObstacleClick);
+    connect(floor, &GridView::cellRightClicked, this, &Visualizer::handleSwampClick);
     setTile({1, 1}, State::start);
-    setTile({WIDTH-2, HEIGHT-2}, State::goal);
+    setTile({width-2, height-2}, State::goal);
 }
 void Visualizer::resetFloor() {
-    for (auto& row : floor) {
-        for (auto& tile : row) {
-            if (tile->isVisited() || tile->isObstacle() || tile->isPath())
-                setTile({tile->y, tile->x}, State::empty);
-        }
-    }
+    stopReplay();
+    floor->clearStates({State::visited, State::obstacle, State::path});
+    floor->clearWeights();
+    this->floorGrid = WeightedGrid(floor->mapWidth(), floor->mapHeight());
     this->searchExecuted = false;
+    this->planner.reset();
 }
 void Visualizer::clearFloor() {
-    for (auto& row : floor) {
-        for (auto& tile : row) {
-            if (tile->isVisited() || tile->isPath())
-                setTile({tile->y, tile->x}, State::empty);
-        }
-    }
+    stopReplay();
+    floor->clearStates({State::visited, State::path});
     this->searchExecuted = false;
 }
 
 void Visualizer::on_Reset_clicked() { resetFloor(); }
 void Visualizer::on_Clear_clicked() { clearFloor(); }
+// Searches stop at the next check of the flag with the path so far, D*
+// Lite, HPA*, flow fields and path databases run to the end
+void Visualizer::cancelSearch() {
+    this->cancelled.store(true);
+}
 void Visualizer::on_Search_clicked() {
-    clearFloor();
-    QFuture<void> future;
-    if (mFuturewatcher.isRunning()) return;
-    if (this->algorithm == Algorithm::breadthFirst) {
-        static Grid grid;
-        future = QtConcurrent::run(grid, &Grid::breadthFirstSearch);
+    if (mFuturewatcher.isRunning()) {
+        cancelSearch();
+        return;
     }
-    else if (this->algorithm == Algorithm::dijkstra) {
-        static WeightedGrid grid;
-        future = QtConcurrent::run(grid, &WeightedGrid::dijkstraSearch);
-    }
-    else if (this->algorithm == Algorithm::astar) {
-        static WeightedGrid grid;
-        future = QtConcurrent::run(grid, &WeightedGrid::aStarSearch);
+    clearFloor();
+    WeightedGrid grid = gridFromFloor();
+    Coordinates start = startCoordinates;
+    Coordinates goal = goalCoordinates;
+    Algorithm algorithm = this->algorithm;
+    SearchOptions options = this->options;
+    SearchTrace* trace = &this->trace;
+    this->cancelled.store(false);
+    options.limits.cancel = &this->cancelled;
+    if (algorithm == Algorithm::dstarLite) {
+        // Only the edits reach the planner, a new goal starts over
+        if (!this->planner || this->planner->goal() != goal)
+            this->planner = std::make_shared<DStarLite>(grid, start, goal, options);
+        for (Coordinates id : this->edits)
+            this->planner->cellChanged(grid, id);
+        this->planner->setStart(start);
+        std::shared_ptr<DStarLite> planner = this->planner;
+        mFuturewatcher.setFuture(QtConcurrent::run([=]() {
+            // Plans do not go through WeightedGrid::search, which records the other searches
+            auto begin = std::chrono::steady_clock::now();
+            SearchResult result = planner->plan(grid, trace);
+            auto end = std::chrono::steady_clock::now();
+            if constexpr (SEARCH_STATS)
+                searchStatistics().record(Algorithm::dstarLite, result,
+                                          std::chrono::duration<double, std::micro>(end - begin).count());
+            return result;
+        }));
+        this->edits.clear();
+        this->searchExecuted = true;
+        return;
     }
+    std::shared_ptr<PathCache> cache = this->cache;
+    QFuture<SearchResult> future = QtConcurrent::run([=]() mutable {
+        // A repeated search only replays its path, nothing is built for it
+        SearchResult result;
+        if (cache->find(grid, algorithm, start, goal, options, result, trace)) return result;
+        // Small clusters, so the entrances show on the default floor
+        if (algorithm == Algorithm::hpa) grid.buildHierarchy(8);
+        if (algorithm == Algorithm::alt) grid.buildLandmarks(8, options);
+        if (algorithm == Algorithm::pathDatabase) grid.buildPathDatabase({goal}, options);
+        result = grid.search(algorithm, start, goal, trace, options);
+        cache->insert(grid, algorithm, start, goal, options, result);
+        return result;
+    });
     mFuturewatcher.setFuture(future);
     this->searchExecuted = true;
 }
@@ -176,14 +238,14 @@ void Visualizer::on_Search_clicked() {
 // Move Start and Goal
 void Visualizer::updateStart(Coordinates id) {
     if (this->searchExecuted) clearFloor();
-    if (inBounds(id) && !floor[id.y][id.x]->isGoal()) {
+    if (floor->inBounds(id) && floor->state(id) != State::goal) {
         setTile(startCoordinates, State::empty);
         setTile(id, State::start);
     }
 }
 void Visualizer::updateGoal(Coordinates id) {
     if (this->searchExecuted) clearFloor();
-    if (inBounds(id) && !floor[id.y][id.x]->isStart()) {
+    if (floor->inBounds(id) && floor->state(id) != State::start) {
         setTile(goalCoordinates, State::empty);
         setTile(id, State::goal);
     }
@@ -199,10 +261,16 @@ void Visualizer::on_DownD_clicked() { updateGoal({goalCoordinates.x, goalCoordin
 void Visualizer::on_RightD_clicked() { updateGoal({goalCoordinates.x+1, goalCoordinates.y}); }
 
 void Visualizer::keyPressEvent(QKeyEvent* event) {
+    // Only Esc while searching, it cancels
+    if (mFuturewatcher.isRunning()) {
+        if (event->key() == Qt::Key_Escape) cancelSearch();
+        return;
+    }
     switch (event->key()) {
         case Qt::Key_Return:    on_Search_clicked(); break;
         case Qt::Key_Backspace: on_Clear_clicked(); break;
         case Qt::Key_R:         on_Reset_clicked(); break;
+        case Qt::Key_Escape:    finishReplay(); break;
         // // WASD
         case Qt::Key_W: on_UpO_clicked(); break;
         case Qt::Key_A: on_LeftO_clicked(); break;
@@ -218,34 +286,50 @@ void Visualizer::keyPressEvent(QKeyEvent* event) {
 }
 
 // Preset printer
-void Visualizer::printPreset(const QVector<QVector<int>>& preset) {
+void Visualizer::printPreset(const QString& resource) {
+    QFile file(resource);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot open preset" << resource;
+        return;
+    }
+    QByteArray data = file.readAll();
+    printMap(parseMovingAiMap(data.constData(), static_cast<std::size_t>(data.size())));
+}
+void Visualizer::printMap(const WeightedGrid& map) {
     resetFloor();
-    for (auto& c : preset)
-        setTile({c[1], c[0]}, State::obstacle);
+    for (int y = 0; y < std::min(map.height(), floor->mapHeight()); ++y) {
+        for (int x = 0; x < std::min(map.width(), floor->mapWidth()); ++x) {
+            if (!map.passable({x, y}))
+                setTile({x, y}, State::obstacle);
+            // The floor paints weights up to 255
+            floor->setWeight({x, y}, static_cast<uchar>(std::min(map.weight({x, y}), 255u)));
+            this->floorGrid.setWeight({x, y}, map.weight({x, y}));
+        }
+    }
 }
 
 void Visualizer::on_Preset1_clicked() {
-    printPreset(this->preset1);
+    printPreset(":/maps/preset1.map");
     updateStart({12, 10});
     updateGoal({34, 1});
 }
 void Visualizer::on_Preset2_clicked() {
-    printPreset(this->preset2);
+    printPreset(":/maps/preset2.map");
     updateStart({0, 1});
     updateGoal({38, 5});
 }
 void Visualizer::on_Preset3_clicked() {
-   printPreset(this->preset3);
+   printPreset(":/maps/preset3.map");
     updateStart({0, 1});
     updateGoal({35, 2});
 }
 void Visualizer::on_Preset4_clicked() {
-   printPreset(this->preset4);
+   printPreset(":/maps/preset4.map");
     updateStart({11, 15});
     updateGoal({22, 4});
 }
 void Visualizer::on_Preset5_clicked() {
-   printPreset(this->preset5);
+   printPreset(":/maps/preset5.map");
     updateStart({11, 9});
     updateGoal({27, 9});
 }
@@ -253,3 +337,15 @@ void Visualizer::on_Preset5_clicked() {
 void Visualizer::on_BreadthSearch_toggled(bool checked) { this->algorithm = Algorithm::breadthFirst; }
 void Visualizer::on_DijkstraSearch_toggled(bool checked) { this->algorithm = Algorithm::dijkstra; }
 void Visualizer::on_AstarSearch_toggled(bool checked) { this->algorithm = Algorithm::astar; }
+void Visualizer::on_JumpPointSearch_toggled(bool checked) { this->algorithm = Algorithm::jps; }
+void Visualizer::on_HierarchicalSearch_toggled(bool checked) { this->algorithm = Algorithm::hpa; }
+void Visualizer::on_LandmarkSearch_toggled(bool checked) { this->algorithm = Algorithm::alt; }
+void Visualizer::on_IncrementalSearch_toggled(bool checked) { this->algorithm = Algorithm::dstarLite; }
+void Visualizer::on_FlowFieldSearch_toggled(bool checked) { this->algorithm = Algorithm::flowField; }
+void Visualizer::on_PathDatabaseSearch_toggled(bool checked) { this->algorithm = Algorithm::pathDatabase; }
+void Visualizer::on_AnytimeSearch_toggled(bool checked) { this->algorithm = Algorithm::anytime; }
+void Visualizer::on_Diagonal_toggled(bool checked) {
+    this->options.connectivity = checked ? Connectivity::eight : Connectivity::four;
+    this->planner.reset();
+}
+void Visualizer::on_Bidirectional_toggled(bool checked) { this->options.bidirectional = checked; }
@@ -0,0 +1,236 @@
+#include "grid.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WAVEFRONT_AVX2
+#endif
+
+// The bit sets are worked on in blocks of 4 words, one AVX2 register
+constexpr std::size_t BLOCK = 4;
+
+// One BFS layer on the listed blocks: next gets the open cells beside
+// the frontier that are not visited yet and visited takes them in. The
+// bitmap rows form one long bitstring, a bit shifted past the end of a
+// row lands in the obstacle border. The bit sets are padded, the open
+// bitmap has exactly words words.
+using LayerKernel = void (*)(const std::uint64_t* open, const std::uint64_t* frontier,
+                             std::uint64_t* next, std::uint64_t* visited,
+                             const std::uint32_t* blocks, std::size_t count,
+                             std::size_t stride, std::size_t words);
+
+static inline void expandWord(const std::uint64_t* open, const std::uint64_t* frontier,
+                              std::uint64_t* next, std::uint64_t* visited,
+                              std::size_t i, std::size_t stride) {
+    std::uint64_t f = frontier[i];
+    std::uint64_t reach = f << 1 | frontier[i - 1] >> 63            // Moving east
+                        | f >> 1 | frontier[i + 1] << 63            // Moving west
+                        | frontier[i - stride] | frontier[i + stride]; // South and north
+    std::uint64_t fresh = reach & open[i] & ~visited[i];
+    next[i] = fresh;
+    visited[i] |= fresh;
+}
+
+static void expandLayerScalar(const std::uint64_t* open, const std::uint64_t* frontier,
+                              std::uint64_t* next, std::uint64_t* visited,
+                              const std::uint32_t* blocks, std::size_t count,
+                              std::size_t stride, std::size_t words) {
+    for (std::size_t k = 0; k < count; ++k) {
+        std::size_t begin = std::size_t(blocks[k]) * BLOCK, end = std::min(begin + BLOCK, words);
+        for (std::size_t i = begin; i < end; ++i)
+            expandWord(open, frontier, next, visited, i, stride);
+    }
+}
+
+#ifdef WAVEFRONT_AVX2
+__attribute__((target("avx2")))
+static inline __m256i load(const std::uint64_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+__attribute__((target("avx2")))
+static void expandLayerAvx2(const std::uint64_t* open, const std::uint64_t* frontier,
+                            std::uint64_t* next, std::uint64_t* visited,
+                            const std::uint32_t* blocks, std::size_t count,
+                            std::size_t stride, std::size_t words) {
+    for (std::size_t k = 0; k < count; ++k) {
+        std::size_t i = std::size_t(blocks[k]) * BLOCK;
+        if (i + BLOCK > words) {
+            // Last block, the open bitmap ends inside it
+            for (; i < words; ++i) expandWord(open, frontier, next, visited, i, stride);
+            continue;
+        }
+        __m256i f = load(frontier + i);
+        __m256i east = _mm256_or_si256(_mm256_slli_epi64(f, 1), _mm256_srli_epi64(load(frontier + i - 1), 63));
+        __m256i west = _mm256_or_si256(_mm256_srli_epi64(f, 1), _mm256_slli_epi64(load(frontier + i + 1), 63));
+        __m256i vertical = _mm256_or_si256(load(frontier + i + stride), load(frontier + i - stride));
+        __m256i reach = _mm256_or_si256(_mm256_or_si256(east, west), vertical);
+        __m256i seen = load(visited + i);
+        __m256i fresh = _mm256_andnot_si256(seen, _mm256_and_si256(reach, load(open + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(next + i), fresh);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(visited + i), _mm256_or_si256(seen, fresh));
+    }
+}
+#endif
+
+static bool avx2Supported() {
+#ifdef WAVEFRONT_AVX2
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+static std::atomic<bool> scalarOnly{false};
+
+bool Grid::wavefrontSimd() {
+    return avx2Supported() && !scalarOnly.load(std::memory_order_relaxed);
+}
+void Grid::setWavefrontSimd(bool enabled) {
+    scalarOnly.store(!enabled, std::memory_order_relaxed);
+}
+
+static LayerKernel layerKernel() {
+#ifdef WAVEFRONT_AVX2
+    if (Grid::wavefrontSimd()) return expandLayerAvx2;
+#endif
+    return expandLayerScalar;
+}
+
+std::size_t Grid::wavefront(SearchSpace& space, int source, int goal, SearchTrace* trace) const {
+    const std::size_t words = bitmapWords(this->mWidth, this->mHeight), row = this->stride;
+    const std::size_t pad = row + BLOCK;
+    const std::ptrdiff_t blocks = static_cast<std::ptrdiff_t>((words + BLOCK - 1) / BLOCK);
+    SearchSpace::Wavefront& wave = space.wave;
+    for (auto* set : {&wave.frontier, &wave.next, &wave.visited}) {
+        if (set->size() != words + 2 * pad) set->assign(words + 2 * pad, 0);
+    }
+    if (wave.marked.size() != std::size_t(blocks)) wave.marked.assign(blocks, 0);
+    space.resetLayers(std::size_t(cellCount()));
+    std::uint64_t* frontier = wave.frontier.data() + pad;
+    std::uint64_t* next = wave.next.data() + pad;
+    std::uint64_t* visited = wave.visited.data() + pad;
+    LayerKernel expandLayer = layerKernel();
+
+    std::size_t bit = bitIndex(coordinates(source));
+    frontier[bit / 64] |= std::uint64_t(1) << (bit % 64);
+    visited[bit / 64] |= std::uint64_t(1) << (bit % 64);
+    space.setLayer(source, 0);
+    std::size_t settled = 1;
+
+    // Only blocks holding frontier bits are active, so a layer costs
+    // the size of the frontier rather than of the map
+    wave.active.assign(1, static_cast<std::uint32_t>(bit / 64 / BLOCK));
+    std::uint32_t lowest = wave.active[0], highest = wave.active[0];
+    auto mark = [&wave, blocks](std::ptrdiff_t first, std::ptrdiff_t last) {
+        for (std::ptrdiff_t b = std::max<std::ptrdiff_t>(first, 0); b <= std::min(last, blocks - 1); ++b) {
+            if (!wave.marked[b]) {
+                wave.marked[b] = 1;
+                wave.candidates.push_back(static_cast<std::uint32_t>(b));
+            }
+        }
+    };
+
+    bool done = source == goal;
+    for (std::uint32_t layer = 1; !done && !wave.active.empty(); ++layer) {
+        // New cells can only appear one word or one row away from the frontier
+        wave.candidates.clear();
+        for (std::uint32_t block : wave.active) {
+            std::ptrdiff_t b = block, first = b * BLOCK, last = first + BLOCK - 1, r = row;
+            mark(b - 1, b + 1);
+            mark((first - r) / std::ptrdiff_t(BLOCK), (last - r) / std::ptrdiff_t(BLOCK));
+            mark((first + r) / std::ptrdiff_t(BLOCK), (last + r) / std::ptrdiff_t(BLOCK));
+        }
+        expandLayer(this->bits.get(), frontier, next, visited,
+                    wave.candidates.data(), wave.candidates.size(), row, words);
+
+        // The frontier buffer takes the layer after next, it has to be clean
+        for (std::uint32_t block : wave.active)
+            std::fill_n(frontier + std::size_t(block) * BLOCK, BLOCK, 0);
+
+        // Every new cell gets its layer
+        wave.active.clear();
+        for (std::uint32_t block : wave.candidates) {
+            wave.marked[block] = 0;
+            bool fresh = false;
+            std::size_t begin = std::size_t(block) * BLOCK, end = std::min(begin + BLOCK, words);
+            for (std::size_t i = begin; i < end; ++i) {
+                if (!next[i]) continue;
+                // Cell of bit 0 of the word, one row and column up for the border
+                int y = int(i / row) - 1, x = int(i % row) * 64 - 1;
+                int base = y * this->mWidth + x;
+                for (std::uint64_t w = next[i]; w; w &= w - 1) {
+                    int cell = base + __builtin_ctzll(w);
+                    space.setLayer(cell, layer);
+                    if (trace) trace->visit(cell);
+                    if (cell == goal) done = true;
+                    ++settled;
+                    fresh = true;
+                }
+            }
+            if (fresh) {
+                wave.active.push_back(block);
+                lowest = std::min(lowest, block);
+                highest = std::max(highest, block);
+            }
+        }
+        std::swap(frontier, next);
+    }
+
+    // Leave the bit sets zero for the next query
+    std::size_t begin = std::size_t(lowest) * BLOCK, end = std::min(std::size_t(highest + 1) * BLOCK, words);
+    for (std::uint64_t* set : {frontier, next, visited})
+        std::fill(set + begin, set + end, 0);
+    return settled;
+}
+
+SearchResult Grid::wavefrontSearch(SearchSpace& space, Coordinates start, Coordinates goal,
+                                   SearchTrace* trace) const {
+    SearchResult result;
+    if (!inBounds(start) || !inBounds(goal)) return result;
+    PhaseTimer timer;
+    int startCell = index(start), goalCell = index(goal);
+    if (trace) beginTrace(*trace);
+    timer.lap(result.stats.setupUs);
+
+    result.expanded = wavefront(space, startCell, goalCell, trace);
+    // Every reached cell joins the bit set of one layer, once
+    if constexpr (SEARCH_STATS) result.stats.pushes = result.stats.relaxations = result.expanded;
+    timer.lap(result.stats.searchUs);
+    if (!space.layerReached(goalCell)) return result;
+
+    // Walk down the layers, taking the first neighbor one layer closer
+    Coordinates id = goal;
+    result.path.push_back(id);
+    for (std::uint32_t layer = space.layer(goalCell); layer > 1; --layer) {
+        bool stepped = false;
+        forEachNeighbor(id, [&](Coordinates next, int nextCell, int) {
+            if (!stepped && space.layerReached(nextCell) && space.layer(nextCell) == layer - 1) {
+                id = next;
+                stepped = true;
+            }
+        });
+        result.path.push_back(id);
+    }
+    // Start may be an obstacle itself, which forEachNeighbor skips
+    if (goalCell != startCell) result.path.push_back(start);
+    std::reverse(result.path.begin(), result.path.end());
+    if (trace) endTrace(*trace, result.path);
+    result.cost = static_cast<double>(result.path.size() - 1);
+    timer.lap(result.stats.pathUs);
+    return result;
+}
+
+std::vector<int> Grid::distanceField(Coordinates source) const {
+    std::vector<int> distances(std::size_t(cellCount()), -1);
+    if (!inBounds(source)) return distances;
+    SearchSpace space;
+    wavefront(space, index(source), -1, nullptr);
+    for (int cell = 0; cell < cellCount(); ++cell) {
+        if (space.layerReached(cell)) distances[cell] = static_cast<int>(space.layer(cell));
+    }
+    return distances;
+}
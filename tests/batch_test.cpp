@@ -0,0 +1,72 @@
+// Batches on one thread and on several give the same answers, with and
+// without a PathCache
+
+#include "batch.h"
+#include "pathcache.h"
+#include "testing.h"
+
+namespace {
+bool sameAnswer(const SearchResult& a, const SearchResult& b) {
+    return a.path == b.path && a.cost == b.cost && a.partial == b.partial;
+}
+
+void testBatches() {
+    std::mt19937 random(6);
+    for (int map = 0; map < 4; ++map) {
+        WeightedGrid grid = randomGrid(random, 30 + int(random() % 40), 30 + int(random() % 40), 0.25,
+                                       map % 2 ? 9 : 1);
+        SearchOptions options;
+        options.connectivity = map < 2 ? Connectivity::four : Connectivity::eight;
+        // HPA* only searches four directions
+        if (options.connectivity == Connectivity::four) grid.buildHierarchy(8, 1);
+        // Repeated queries and few goals, so caches and flow fields get hits
+        std::vector<Query> queries;
+        std::vector<Coordinates> goals{randomCell(random, grid), randomCell(random, grid)};
+        for (int k = 0; k < 60; ++k) {
+            Query query;
+            query.start = randomCell(random, grid);
+            query.goal = goals[k % 2];
+            queries.push_back(query);
+            if (k % 5 == 0) queries.push_back(queries[random() % queries.size()]);
+        }
+
+        for (Algorithm algorithm : {Algorithm::breadthFirst, Algorithm::dijkstra, Algorithm::astar,
+                                    Algorithm::hpa, Algorithm::flowField}) {
+            if (algorithm == Algorithm::hpa && options.connectivity == Connectivity::eight) continue;
+            std::string name = std::string(algorithmName(algorithm)) + " batch on map " + std::to_string(map);
+            std::vector<BatchResult> one = searchBatch(grid, algorithm, queries, 1, options);
+            std::vector<BatchResult> many = searchBatch(grid, algorithm, queries, 4, options);
+            bool same = one.size() == queries.size() && many.size() == queries.size();
+            for (std::size_t i = 0; same && i < queries.size(); ++i)
+                same = sameAnswer(one[i].result, many[i].result) && one[i].result.expanded == many[i].result.expanded;
+            check(same, name + " on 4 threads");
+
+            // Exact hits are the answers of the searches they replace
+            PathCache exact(64, false);
+            many = searchBatch(grid, algorithm, queries, 4, options, &exact);
+            same = many.size() == queries.size();
+            for (std::size_t i = 0; same && i < queries.size(); ++i)
+                same = sameAnswer(one[i].result, many[i].result);
+            // Flow fields bypass the cache
+            check(same && (exact.hits() > 0 || algorithm == Algorithm::flowField), name + " with a cache");
+
+            // Parts of cached paths may take other paths of the same cost
+            PathCache parts(1024, true);
+            many = searchBatch(grid, algorithm, queries, 4, options, &parts);
+            same = many.size() == queries.size();
+            for (std::size_t i = 0; same && i < queries.size(); ++i) {
+                const SearchResult& a = one[i].result;
+                const SearchResult& b = many[i].result;
+                same = a.found() == b.found() && validPath(grid, b.path, queries[i].start, queries[i].goal, options)
+                    && (algorithm == Algorithm::hpa ? sameAnswer(a, b) : near(a.cost, b.cost, 1e-3));
+            }
+            check(same, name + " with a cache of sub-paths");
+        }
+    }
+}
+}
+
+int main() {
+    testBatches();
+    return finish();
+}
@@ -0,0 +1,92 @@
+// Connected components against a flood fill and Dijkstra under every
+// step rule, while edits open and close cells
+
+#include "components.h"
+#include "testing.h"
+
+namespace {
+// Labels of a flood fill under the steps of options, -1 for obstacles
+std::vector<int> floodFill(const WeightedGrid& grid, const SearchOptions& options) {
+    std::vector<int> labels(std::size_t(grid.cellCount()), -1);
+    std::vector<int> stack;
+    for (int seed = 0; seed < grid.cellCount(); ++seed) {
+        if (labels[seed] >= 0 || !grid.passable(grid.coordinates(seed))) continue;
+        labels[seed] = seed;
+        stack.push_back(seed);
+        while (!stack.empty()) {
+            Coordinates id = grid.coordinates(stack.back());
+            stack.pop_back();
+            grid.forEachNeighbor(id, options.connectivity, options.cornerCutting,
+                                 [&](Coordinates, int nextCell, int) {
+                if (labels[nextCell] < 0) {
+                    labels[nextCell] = seed;
+                    stack.push_back(nextCell);
+                }
+            });
+        }
+    }
+    return labels;
+}
+
+// Same partition of the open cells, with the sizes of the components
+bool samePartition(const WeightedGrid& grid, const Components& components, const std::vector<int>& labels) {
+    std::vector<int> toComponent(labels.size(), Components::NONE);
+    std::vector<std::size_t> sizes(labels.size(), 0);
+    std::size_t count = 0;
+    for (int cell = 0; cell < grid.cellCount(); ++cell) {
+        int component = components.component(cell);
+        if ((labels[cell] < 0) != (component == Components::NONE)) return false;
+        if (labels[cell] < 0) continue;
+        if (toComponent[labels[cell]] == Components::NONE) {
+            toComponent[labels[cell]] = component;
+            ++count;
+        }
+        if (toComponent[labels[cell]] != component) return false;
+        ++sizes[labels[cell]];
+    }
+    for (std::size_t label = 0; label < labels.size(); ++label)
+        if (toComponent[label] != Components::NONE && components.size(toComponent[label]) != sizes[label])
+            return false;
+    // Different labels mapped to one component show in the count
+    return components.count() == count;
+}
+
+void testComponents() {
+    std::mt19937 random(19);
+    SearchSpace space;
+    const std::vector<SearchOptions> rules = stepRules();
+    for (int map = 0; map < 16; ++map) {
+        int width = 6 + int(random() % 40), height = 6 + int(random() % 40);
+        unsigned maxWeight = map % 2 ? 1 : 9;
+        // Dense enough to split into many areas
+        WeightedGrid grid = randomGrid(random, width, height, 0.35 + 0.05 * (map % 3), maxWeight);
+        SearchOptions options = rules[map % rules.size()];
+        options.frontier = Frontier::binaryHeap;
+        grid.buildComponents(options);
+        for (int round = 0; round < 6; ++round) {
+            const Components* components = grid.components();
+            check(components != nullptr && samePartition(grid, *components, floodFill(grid, options)),
+                  "components of map " + std::to_string(map) + " after " + std::to_string(round) + " rounds of edits");
+            for (int query = 0; query < 8; ++query) {
+                // Starts inside obstacles too
+                Coordinates start{int(random() % grid.width()), int(random() % grid.height())};
+                Coordinates goal = randomCell(random, grid);
+                SearchResult reference = grid.dijkstraSearch(space, start, goal, nullptr, options);
+                std::string what = describe("components", start, goal, options);
+                check(components->connected(grid, start, goal) == reference.found(), what + " connected");
+                SearchResult result = grid.search(space, Algorithm::dijkstra, start, goal, nullptr, options);
+                check(result.found() == reference.found(), what + " search found");
+                if (!reference.found()) check(result.expanded == 0, what + " rejected without a search");
+                else check(near(result.cost, reference.cost), what + " search cost");
+            }
+            for (int edit = 0; edit < 10; ++edit)
+                randomEdit(random, grid, maxWeight);
+        }
+    }
+}
+}
+
+int main() {
+    testComponents();
+    return finish();
+}
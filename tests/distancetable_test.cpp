@@ -0,0 +1,138 @@
+// Distance tables and path databases against single pair Dijkstra,
+// path database files through save, load, truncation and forged headers
+
+#include "distancetable.h"
+#include "mapfile.h"
+#include "testing.h"
+
+namespace {
+// Every entry, with sources and targets inside obstacles, off the map
+// and repeated
+void testDistanceTables() {
+    std::mt19937 random(23);
+    SearchSpace space;
+    const std::vector<SearchOptions> rules = stepRules();
+    for (int map = 0; map < 12; ++map) {
+        int width = 6 + int(random() % 30), height = 6 + int(random() % 30);
+        unsigned maxWeight = map % 3 == 0 ? 1 : map % 3 == 1 ? 9 : 300;
+        WeightedGrid grid = randomGrid(random, width, height, 0.3, maxWeight);
+        SearchOptions options = rules[map % rules.size()];
+        options.frontier = Frontier::binaryHeap;
+        auto anyCell = [&]() { return Coordinates{int(random() % width), int(random() % height)}; };
+        std::vector<Coordinates> sources, targets;
+        for (int i = 0; i < 8; ++i) {
+            sources.push_back(i % 3 == 0 ? anyCell() : randomCell(random, grid));
+            targets.push_back(i % 3 == 0 ? anyCell() : randomCell(random, grid));
+        }
+        sources.push_back(sources[1]);
+        targets.push_back(targets[1]);
+        targets.push_back(sources[2]);
+        sources.push_back({width, 0});
+        targets.push_back({-1, 0});
+
+        DistanceTable table(grid, sources, targets, options, 1 + map % 3);
+        check(table.matrix().size() == sources.size() * targets.size(), "distance table size");
+        for (std::size_t s = 0; s < sources.size(); ++s) {
+            for (std::size_t t = 0; t < targets.size(); ++t) {
+                Coordinates start = sources[s], goal = targets[t];
+                Cost cost = table.cost(s, t);
+                std::string what = describe("distance table", start, goal, options);
+                if (!grid.inBounds(start) || !grid.inBounds(goal)) {
+                    check(cost == DistanceTable::UNREACHABLE, what + " off the map");
+                    continue;
+                }
+                SearchResult reference = grid.dijkstraSearch(space, start, goal, nullptr, options);
+                check((cost != DistanceTable::UNREACHABLE) == reference.found(), what + " found");
+                if (reference.found())
+                    check(cost == Cost(std::llround(reference.cost * COST_SCALE)), what + " cost "
+                          + std::to_string(cost) + " instead of " + std::to_string(reference.cost));
+            }
+        }
+    }
+}
+
+// Queries to targets walk the database, others fall back to A*, and
+// edits drop it
+void testPathDatabases() {
+    std::mt19937 random(24);
+    SearchSpace space;
+    const std::vector<SearchOptions> rules = stepRules();
+    for (int map = 0; map < 12; ++map) {
+        int width = 6 + int(random() % 40), height = 6 + int(random() % 40);
+        unsigned maxWeight = map % 2 ? 1 : 9;
+        WeightedGrid grid = randomGrid(random, width, height, 0.25, maxWeight);
+        SearchOptions options = rules[map % rules.size()];
+        options.frontier = Frontier::binaryHeap;
+        for (int round = 0; round < 2; ++round) {
+            std::vector<Coordinates> goals;
+            for (int i = 0; i < 6; ++i)
+                goals.push_back(randomCell(random, grid));
+            grid.buildPathDatabase(goals, options, 1 + map % 2);
+            check(grid.pathDatabase() != nullptr && grid.pathDatabase()->covers(options), "path database built");
+            for (int query = 0; query < 16; ++query) {
+                Coordinates start = randomCell(random, grid);
+                Coordinates goal = query % 4 == 3 ? randomCell(random, grid) : goals[random() % goals.size()];
+                SearchResult reference = grid.dijkstraSearch(space, start, goal, nullptr, options);
+                SearchResult cpd = grid.search(space, Algorithm::pathDatabase, start, goal, nullptr, options);
+                std::string what = describe("cpd", start, goal, options);
+                check(cpd.found() == reference.found(), what + " found");
+                check(validPath(grid, cpd.path, start, goal, options), what + " path");
+                if (cpd.found() && reference.found())
+                    check(near(cpd.cost, reference.cost) && near(cpd.cost, pathCost(grid, cpd.path)),
+                          what + " cost " + std::to_string(cpd.cost) + " instead of " + std::to_string(reference.cost));
+                if (grid.pathDatabase()->row(grid.index(goal)) >= 0)
+                    check(cpd.expanded == 0, what + " walks the database");
+            }
+            for (int edit = 0; edit < 12; ++edit)
+                randomEdit(random, grid, maxWeight);
+            check(grid.pathDatabase() == nullptr, "edits drop the path database");
+        }
+    }
+}
+
+void testPathDatabaseFiles() {
+    std::string path = scratchPath(".cpd");
+    std::mt19937 random(25);
+    SearchOptions options = stepRules()[1];
+    WeightedGrid grid = randomGrid(random, 50, 40, 0.25, 9);
+    std::vector<Coordinates> goals;
+    for (int i = 0; i < 5; ++i)
+        goals.push_back(randomCell(random, grid));
+    PathDatabase built(grid, goals, options, 1);
+    savePathDatabase(built, path);
+
+    std::shared_ptr<const PathDatabase> loaded = loadPathDatabase(path, grid);
+    bool same = loaded->targetCount() == built.targetCount() && loaded->covers(options)
+             && loaded->runCount() == built.runCount()
+             && std::memcmp(loaded->runs(), built.runs(), built.runCount() * sizeof(std::uint32_t)) == 0
+             && std::memcmp(loaded->offsets(), built.offsets(),
+                            (std::size_t(built.targetCount()) + 1) * sizeof(std::uint64_t)) == 0;
+    for (int row = 0; same && row < built.targetCount(); ++row)
+        same = loaded->target(row) == built.target(row);
+    check(same, "path database round trip");
+    for (int query = 0; query < 20; ++query) {
+        Coordinates start = randomCell(random, grid), goal = goals[random() % goals.size()];
+        check(loaded->path(grid, start, goal).path == built.path(grid, start, goal).path,
+              describe("cpd on a loaded database", start, goal, options));
+    }
+
+    std::string bytes = readFile(path);
+    auto load = [&grid](const std::string& file) { loadPathDatabase(file, grid); };
+    checkTruncations("path database", path, bytes, load);
+    // Header alone, claiming many targets and no runs
+    for (std::uint32_t targets : {1000u, 0xffffffffu}) {
+        std::string forged = bytes.substr(0, 64);
+        patch<std::uint32_t>(forged, 20, targets);
+        patch<std::uint64_t>(forged, 32, 0);
+        check(throws(path, forged, load), "path database with " + std::to_string(targets) + " forged targets");
+    }
+    std::remove(path.c_str());
+}
+}
+
+int main() {
+    testDistanceTables();
+    testPathDatabases();
+    testPathDatabaseFiles();
+    return finish();
+}
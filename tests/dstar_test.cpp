@@ -0,0 +1,43 @@
+// D* Lite against Dijkstra while the start moves and the map changes
+
+#include "dstar.h"
+#include "testing.h"
+
+namespace {
+// The planner keeps its search over edits and a moving start
+void testReplanning() {
+    std::mt19937 random(7);
+    SearchSpace space;
+    for (int map = 0; map < 12; ++map) {
+        int size = 10 + int(random() % 30);
+        unsigned maxWeight = map % 2 ? 20 : 1;
+        WeightedGrid grid = randomGrid(random, size, size, 0.2, maxWeight);
+        SearchOptions options = stepRules()[map % 4];
+        Coordinates start = randomCell(random, grid), goal = randomCell(random, grid);
+        DStarLite planner(grid, start, goal, options);
+        for (int step = 0; step < 8; ++step) {
+            SearchResult planned = planner.plan(grid);
+            SearchResult reference = grid.dijkstraSearch(space, planner.start(), planner.goal(), nullptr, options);
+            check(planned.found() == reference.found() && (!planned.found() || near(planned.cost, reference.cost))
+                  && validPath(grid, planned.path, planner.start(), planner.goal(), options),
+                  describe("dstar replanning", planner.start(), planner.goal(), options));
+            // Move along the plan, then edit a few cells
+            if (planned.path.size() > 2) planner.setStart(planned.path[1]);
+            for (int edit = 0; edit < 6; ++edit) {
+                Coordinates id{int(random() % size), int(random() % size)};
+                if (id == planner.start() || id == planner.goal()) continue;
+                if (maxWeight > 1 && random() % 2) grid.setWeight(id, 1 + random() % maxWeight);
+                else grid.setObstacle(id, random() % 2 != 0);
+                planner.cellChanged(grid, id);
+            }
+            // Now and then somewhere else entirely
+            if (step == 5) planner.setGoal(randomCell(random, grid));
+        }
+    }
+}
+}
+
+int main() {
+    testReplanning();
+    return finish();
+}
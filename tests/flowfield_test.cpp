@@ -0,0 +1,86 @@
+// Flow fields over several tiles, on every step rule and on weighted
+// terrain, against Dijkstra before and after edits
+
+#include "flowfield.h"
+#include "testing.h"
+
+namespace {
+// Distances rounded down to the unit of the field, and walks that cost
+// what Dijkstra does, from open cells and from inside obstacles
+void checkField(const WeightedGrid& grid, SearchSpace& space, const FlowField& field, std::mt19937& random,
+                const SearchOptions& options, const std::string& name) {
+    Coordinates goal = field.goal();
+    for (int query = 0; query < 16; ++query) {
+        Coordinates start{int(random() % grid.width()), int(random() % grid.height())};
+        if (query % 4 != 0) start = randomCell(random, grid);
+        int cell = grid.index(start);
+        SearchResult reference = grid.dijkstraSearch(space, start, goal, nullptr, options);
+        std::string what = describe(name.c_str(), start, goal, options);
+        check(field.reachable(cell) == reference.found(), what + " reachable");
+        SearchResult walk = field.path(grid, start);
+        check(walk.found() == reference.found() && validPath(grid, walk.path, start, goal, options), what + " path");
+        if (!reference.found()) continue;
+        Cost exact = Cost(std::llround(reference.cost * COST_SCALE));
+        check(field.distance(cell) <= exact && exact < field.distance(cell) + field.unit(), what + " distance "
+              + std::to_string(field.distance(cell)) + " for " + std::to_string(exact));
+        check(near(walk.cost, reference.cost) && near(walk.cost, pathCost(grid, walk.path)), what + " cost "
+              + std::to_string(walk.cost) + " instead of " + std::to_string(reference.cost));
+    }
+    // The goal itself, and a start off the map
+    SearchResult atGoal = field.path(grid, goal);
+    check(atGoal.path.size() == 1 && atGoal.cost == 0, name + " path at the goal");
+    check(field.path(grid, {-1, 0}).path.empty(), name + " path from off the map");
+}
+
+// Maps larger than one default tile, and small maps cut into tiles of
+// 8 and of 5 cells, which do not divide them
+void testFlowFields() {
+    std::mt19937 random(22);
+    SearchSpace space;
+    const std::vector<SearchOptions> rules = stepRules();
+    struct Case { int width, height, tileSize; };
+    const Case cases[] = {{150, 90, 64}, {70, 140, 64}, {40, 36, 8}, {33, 41, 5}, {21, 17, 8}, {64, 64, 16}};
+    int map = 0;
+    for (const Case& shape : cases) {
+        for (unsigned maxWeight : {1u, 9u}) {
+            WeightedGrid grid = randomGrid(random, shape.width, shape.height, 0.25, maxWeight);
+            SearchOptions options = rules[map++ % rules.size()];
+            options.frontier = Frontier::binaryHeap;
+            for (int round = 0; round < 2; ++round) {
+                Coordinates goal = randomCell(random, grid);
+                for (unsigned threads : {1u, 4u}) {
+                    FlowField field(grid, goal, options, threads, shape.tileSize);
+                    std::string name = "flow " + std::to_string(shape.width) + "x" + std::to_string(shape.height)
+                                     + " tiles " + std::to_string(shape.tileSize) + " threads "
+                                     + std::to_string(threads) + " weights " + std::to_string(maxWeight);
+                    checkField(grid, space, field, random, options, name);
+                }
+                for (int edit = 0; edit < 40; ++edit)
+                    randomEdit(random, grid, maxWeight);
+            }
+        }
+    }
+}
+
+// A wall splits the map: the other side is unreached, and its walks
+// come back empty instead of running on
+void testUnreachable() {
+    WeightedGrid grid(130, 20);
+    for (int y = 0; y < 20; ++y)
+        grid.setObstacle({70, y});
+    FlowField field(grid, {10, 10}, {}, 0, 16);
+    check(!field.reachable(grid.index({100, 5})) && field.direction(grid.index({100, 5})) == FlowField::NONE
+          && field.distance(grid.index({100, 5})) == ~Cost(0), "cell behind a wall unreached");
+    check(field.path(grid, {100, 5}).path.empty() && !field.path(grid, {100, 5}).found(), "no path behind a wall");
+    SearchSpace space;
+    SearchResult walk = field.path(grid, {69, 19});
+    SearchResult reference = grid.dijkstraSearch(space, {69, 19}, {10, 10});
+    check(walk.found() && walk.path.size() == 59 + 9 + 1 && near(walk.cost, reference.cost), "path on the side of the goal");
+}
+}
+
+int main() {
+    testFlowFields();
+    testUnreachable();
+    return finish();
+}
@@ -0,0 +1,127 @@
+// The bucket queue, the radix heap and the indexed heap against the
+// binary heap, alone and under Dijkstra and A*
+
+#include "frontier.h"
+#include "testing.h"
+
+#include <map>
+
+namespace {
+// Monotone runs of puts and gets, the spread of the priorities queued at
+// once up to spread, so the bucket queue grows, wraps and overflows
+template <class Queue>
+bool sameOrder(Queue& queue, std::mt19937& random, Cost spread, std::size_t items) {
+    PrioriyQueue<int, Cost> reference;
+    queue.reset(items);
+    std::map<int, Cost> queued; // Item to priority, items are put once
+    Cost last = 0;
+    int next = 0;
+    for (int step = 0; step < 4000; ++step) {
+        if (next < int(items) && (random() % 3 != 0 || reference.empty())) {
+            Cost priority = last + random() % (spread + 1);
+            queue.put(next, priority);
+            reference.put(next, priority);
+            queued[next++] = priority;
+        } else if (!reference.empty()) {
+            Cost expected, got;
+            reference.get(expected);
+            int item = queue.get(got);
+            auto found = queued.find(item);
+            if (got != expected || found == queued.end() || found->second != got) return false;
+            queued.erase(found);
+            last = got;
+        }
+    }
+    while (!reference.empty()) {
+        Cost expected, got;
+        reference.get(expected);
+        if (queue.empty() || (queue.get(got), got != expected)) return false;
+    }
+    return queue.empty();
+}
+
+void testQueues() {
+    std::mt19937 random(9);
+    BucketQueue buckets;
+    RadixHeap radix;
+    IndexedHeap indexed;
+    // Reused across resets, like a SearchSpace does
+    for (Cost spread : {Cost(1), Cost(2500), Cost(70000), Cost(5000000), Cost(100)}) {
+        for (std::size_t items : {std::size_t(3000), std::size_t(500)}) {
+            std::string what = " with a spread of " + std::to_string(spread);
+            check(sameOrder(buckets, random, spread, items), "bucket queue" + what);
+            check(sameOrder(radix, random, spread, items), "radix heap" + what);
+            check(sameOrder(indexed, random, spread, items), "indexed heap" + what);
+        }
+    }
+
+    // The indexed heap lowers and raises queued items in place
+    indexed.reset(100);
+    std::map<int, Cost> priorities;
+    for (int step = 0; step < 1000; ++step) {
+        int item = int(random() % 100);
+        Cost priority = random() % 1000;
+        indexed.put(item, priority);
+        priorities[item] = priority;
+    }
+    bool ordered = true;
+    Cost last = 0;
+    while (!indexed.empty()) {
+        Cost priority;
+        int item = indexed.get(priority);
+        ordered = ordered && priority >= last && priorities.count(item) && priorities[item] == priority;
+        priorities.erase(item);
+        last = priority;
+    }
+    check(ordered && priorities.empty(), "indexed heap updates");
+}
+
+// Dijkstra and A* on every frontier, against Dijkstra on a binary heap
+void testSearches() {
+    std::mt19937 random(2024);
+    SearchSpace space;
+    for (int map = 0; map < 16; ++map) {
+        int width = 6 + int(random() % 40), height = 6 + int(random() % 40);
+        WeightedGrid grid = randomGrid(random, width, height, 0.25, map % 3 == 0 ? 1 : map % 3 == 1 ? 9 : 3000);
+        SearchOptions options;
+        options.connectivity = map % 2 ? Connectivity::eight : Connectivity::four;
+        for (int query = 0; query < 8; ++query) {
+            Coordinates start = randomCell(random, grid), goal = randomCell(random, grid);
+            options.frontier = Frontier::binaryHeap;
+            SearchResult reference = grid.dijkstraSearch(space, start, goal, nullptr, options);
+            for (Frontier frontier : {Frontier::bucketQueue, Frontier::radixHeap, Frontier::indexedHeap}) {
+                options.frontier = frontier;
+                for (Algorithm algorithm : {Algorithm::dijkstra, Algorithm::astar}) {
+                    SearchResult result = grid.search(space, algorithm, start, goal, nullptr, options);
+                    check(result.found() == reference.found() && near(result.cost, reference.cost)
+                          && validPath(grid, result.path, start, goal, options),
+                          describe(algorithmName(algorithm), start, goal, options));
+                }
+            }
+        }
+    }
+}
+
+// A heavy row far beyond the ring of the bucket queue
+void testWideWeights() {
+    SearchSpace space;
+    WeightedGrid grid(64, 64);
+    for (int x = 0; x < 64; ++x)
+        grid.setWeight({x, 32}, 60000);
+    SearchOptions options;
+    options.frontier = Frontier::binaryHeap;
+    SearchResult reference = grid.dijkstraSearch(space, {0, 0}, {63, 63}, nullptr, options);
+    for (Frontier frontier : {Frontier::bucketQueue, Frontier::radixHeap, Frontier::indexedHeap}) {
+        options.frontier = frontier;
+        SearchResult result = grid.dijkstraSearch(space, {0, 0}, {63, 63}, nullptr, options);
+        check(near(result.cost, reference.cost), std::string("wide weights on ") + frontierName(frontier));
+    }
+}
+}
+
+int main() {
+    testQueues();
+    testSearches();
+    testWideWeights();
+    return finish();
+}
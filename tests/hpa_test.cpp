@@ -0,0 +1,76 @@
+// HPA* against Dijkstra on random four-connected grids, with the
+// hierarchy kept up to date by edits and rebuilt by setWeights
+
+#include "hpa.h"
+#include "testing.h"
+
+namespace {
+void checkQuery(const WeightedGrid& grid, SearchSpace& space, Coordinates start, Coordinates goal) {
+    SearchOptions options;
+    options.frontier = Frontier::binaryHeap;
+    SearchResult reference = grid.dijkstraSearch(space, start, goal, nullptr, options);
+    SearchResult result = grid.search(space, Algorithm::hpa, start, goal, nullptr, options);
+    check(result.found() == reference.found(), describe("hpa found", start, goal, options));
+    check(validPath(grid, result.path, start, goal, options), describe("hpa path", start, goal, options));
+    // Paths pass the transitions and may be longer
+    if (result.found() && reference.found())
+        check(result.cost >= reference.cost - 1e-6 && near(result.cost, pathCost(grid, result.path)),
+              describe("hpa cost", start, goal, options));
+}
+
+void testHierarchy() {
+    std::mt19937 random(15);
+    SearchSpace space;
+    for (int map = 0; map < 6; ++map) {
+        int width = 6 + int(random() % 40), height = 6 + int(random() % 40);
+        unsigned maxWeight = map % 3 == 0 ? 1 : map % 3 == 1 ? 9 : 300;
+        WeightedGrid grid = randomGrid(random, width, height, 0.25, maxWeight);
+        grid.buildHierarchy(map % 2 ? 8 : 5, 1);
+        for (int round = 0; round < 2; ++round) {
+            for (int query = 0; query < 8; ++query)
+                checkQuery(grid, space, randomCell(random, grid), randomCell(random, grid));
+            // Edits redo the clusters around them, which answer like a
+            // hierarchy built from scratch
+            for (int edit = 0; edit < 4; ++edit)
+                randomEdit(random, grid, maxWeight);
+            WeightedGrid rebuilt = grid;
+            rebuilt.buildHierarchy(map % 2 ? 8 : 5, 1);
+            for (int query = 0; query < 8; ++query) {
+                Coordinates start = randomCell(random, grid), goal = randomCell(random, grid);
+                SearchResult updated = grid.search(space, Algorithm::hpa, start, goal);
+                SearchResult built = rebuilt.search(space, Algorithm::hpa, start, goal);
+                check(updated.path == built.path, describe("hpa after edits", start, goal, {}));
+            }
+        }
+    }
+}
+
+// Weights set all at once under a hierarchy
+void testSetWeights() {
+    SearchSpace space;
+    WeightedGrid flat(64, 64);
+    flat.buildHierarchy(8, 1);
+    std::shared_ptr<std::uint8_t> weights(new std::uint8_t[64 * 64], std::default_delete<std::uint8_t[]>());
+    std::fill_n(weights.get(), 64 * 64, 50);
+    flat.setWeights(weights);
+    SearchResult hpa = flat.search(space, Algorithm::hpa, {0, 0}, {63, 63});
+    SearchResult dijkstra = flat.dijkstraSearch(space, {0, 0}, {63, 63});
+    check(hpa.found() && hpa.cost >= dijkstra.cost - 1e-6, "hpa after setWeights");
+}
+
+void testClusterSizes() {
+    WeightedGrid grid(20, 10);
+    check(Hierarchy(grid, 0, 1).clusterSize() == 1, "cluster size clamped to 1");
+    check(Hierarchy(grid, 1 << 30, 1).clusterSize() == Hierarchy::MAX_CLUSTER_SIZE, "cluster size clamped");
+    SearchSpace space;
+    grid.buildHierarchy(1 << 30, 1);
+    check(grid.search(space, Algorithm::hpa, {0, 0}, {19, 9}).path.size() == 29, "one cluster for the map");
+}
+}
+
+int main() {
+    testHierarchy();
+    testSetWeights();
+    testClusterSizes();
+    return finish();
+}
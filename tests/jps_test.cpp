@@ -0,0 +1,43 @@
+// Jump point search, scanning and with the jump table, against Dijkstra
+// on random grids before and after edits
+
+#include "testing.h"
+
+namespace {
+void testJumpPointSearch() {
+    std::mt19937 random(10);
+    SearchSpace space;
+    SearchOptions options;
+    options.frontier = Frontier::binaryHeap;
+    for (int map = 0; map < 24; ++map) {
+        int width = 6 + int(random() % 50), height = 6 + int(random() % 50);
+        WeightedGrid grid = randomGrid(random, width, height, map % 2 ? 0.1 : 0.3);
+        for (int round = 0; round < 2; ++round) {
+            for (bool table : {false, true}) {
+                if (table) grid.precomputeJumps();
+                for (int query = 0; query < 8; ++query) {
+                    Coordinates start = randomCell(random, grid), goal = randomCell(random, grid);
+                    SearchResult reference = grid.dijkstraSearch(space, start, goal, nullptr, options);
+                    SearchResult jps = grid.search(space, Algorithm::jps, start, goal, nullptr, options);
+                    std::string what = describe(table ? "jps with the table" : "jps", start, goal, options);
+                    check(jps.found() == reference.found(), what + " found");
+                    check(validPath(grid, jps.path, start, goal, options), what + " path");
+                    // Uniform steps, without the nudge of Dijkstra
+                    std::size_t steps = reference.path.size();
+                    if (jps.found() && reference.found())
+                        check(jps.cost <= reference.cost + 1e-6 && reference.cost - jps.cost <= steps * 0.001 + 1e-6
+                              && jps.path.size() == steps, what + " cost");
+                }
+            }
+            for (int edit = 0; edit < 12; ++edit)
+                randomEdit(random, grid);
+            check(!grid.hasJumpTable(), "edits drop the jump table");
+        }
+    }
+}
+}
+
+int main() {
+    testJumpPointSearch();
+    return finish();
+}
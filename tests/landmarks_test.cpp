@@ -0,0 +1,94 @@
+// ALT against Dijkstra under every step rule and on weighted terrain,
+// landmark files through save, load, truncation and forged headers
+
+#include "mapfile.h"
+#include "testing.h"
+
+namespace {
+// Landmarks are built for the steps of the map, and edits drop them
+void testAlt() {
+    std::mt19937 random(18);
+    SearchSpace space;
+    const std::vector<SearchOptions> rules = stepRules();
+    for (int map = 0; map < 16; ++map) {
+        int width = 6 + int(random() % 40), height = 6 + int(random() % 40);
+        unsigned maxWeight = map % 2 ? 1 : 40;
+        WeightedGrid grid = randomGrid(random, width, height, 0.25, maxWeight);
+        SearchOptions options = rules[map % rules.size()];
+        options.frontier = Frontier::binaryHeap;
+        for (int round = 0; round < 2; ++round) {
+            grid.buildLandmarks(1 + map % 6, options);
+            check(grid.landmarks() != nullptr && grid.landmarks()->covers(options), "landmarks built");
+            for (int query = 0; query < 8; ++query) {
+                Coordinates start = randomCell(random, grid), goal = randomCell(random, grid);
+                SearchResult reference = grid.dijkstraSearch(space, start, goal, nullptr, options);
+                SearchResult alt = grid.search(space, Algorithm::alt, start, goal, nullptr, options);
+                std::string what = describe("alt", start, goal, options);
+                check(alt.found() == reference.found(), what + " found");
+                check(validPath(grid, alt.path, start, goal, options), what + " path");
+                if (alt.found() && reference.found())
+                    check(near(alt.cost, reference.cost) && near(alt.cost, pathCost(grid, alt.path)),
+                          what + " cost " + std::to_string(alt.cost) + " instead of " + std::to_string(reference.cost));
+                // The bounds never exceed the cost to the goal
+                if (reference.found())
+                    check(grid.landmarks()->lowerBound(grid.index(start), grid.index(goal))
+                          <= Cost(std::llround(reference.cost * COST_SCALE)), what + " lower bound");
+            }
+            for (int edit = 0; edit < 12; ++edit)
+                randomEdit(random, grid, maxWeight);
+            check(grid.landmarks() == nullptr, "edits drop the landmarks");
+        }
+    }
+
+    // The count is clamped
+    WeightedGrid open(12, 12);
+    open.buildLandmarks(1000);
+    check(open.landmarks()->count() <= Landmarks::MAX_COUNT, "landmark count clamped");
+}
+
+void testLandmarkFiles() {
+    std::string path = scratchPath(".landmarks");
+    std::mt19937 random(41);
+    SearchSpace space;
+    SearchOptions options = stepRules()[1];
+    WeightedGrid grid = randomGrid(random, 40, 30, 0.25, 9);
+    grid.buildLandmarks(4, options);
+    saveLandmarks(*grid.landmarks(), path);
+
+    WeightedGrid copy = grid;
+    copy.setLandmarks(loadLandmarks(path, copy));
+    const Landmarks& built = *grid.landmarks();
+    const Landmarks& loaded = *copy.landmarks();
+    bool same = loaded.count() == built.count() && loaded.covers(options) && loaded.tableSize() == built.tableSize()
+             && std::memcmp(loaded.table(), built.table(), built.tableSize() * sizeof(std::uint16_t)) == 0;
+    for (int k = 0; same && k < built.count(); ++k)
+        same = loaded.cell(k) == built.cell(k) && loaded.unit(k) == built.unit(k);
+    check(same, "landmark round trip");
+    for (int query = 0; query < 20; ++query) {
+        Coordinates start = randomCell(random, grid), goal = randomCell(random, grid);
+        SearchResult before = grid.search(space, Algorithm::alt, start, goal, nullptr, options);
+        SearchResult after = copy.search(space, Algorithm::alt, start, goal, nullptr, options);
+        check(after.path == before.path && after.expanded == before.expanded,
+              describe("alt on loaded landmarks", start, goal, options));
+    }
+
+    std::string bytes = readFile(path);
+    auto load = [&grid](const std::string& file) { loadLandmarks(file, grid); };
+    checkTruncations("landmarks", path, bytes, load);
+    std::string forged = bytes;
+    patch<std::uint32_t>(forged, 20, 0xffffffff);
+    check(throws(path, forged, load), "landmarks with a forged count");
+    forged = bytes;
+    patch<std::uint32_t>(forged, 20, std::uint32_t(Landmarks::MAX_COUNT + 1));
+    check(throws(path, forged, load), "landmarks above the largest count");
+    check(throws(path, bytes, [](const std::string& file) { loadLandmarks(file, WeightedGrid(41, 30)); }),
+          "landmarks of a map of another size");
+    std::remove(path.c_str());
+}
+}
+
+int main() {
+    testAlt();
+    testLandmarkFiles();
+    return finish();
+}
@@ -0,0 +1,157 @@
+// Search limits: cancel flags, deadlines, budgets and expansion caps
+// give partial results from the start, and ARA* against Dijkstra with
+// and without them
+
+#include "testing.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace {
+struct Limited {
+    const char* name;
+    Algorithm algorithm;
+    bool bidirectional;
+};
+
+const Limited LIMITED[] = {
+    {"bfs", Algorithm::breadthFirst, false}, {"dijkstra", Algorithm::dijkstra, false},
+    {"astar", Algorithm::astar, false},      {"jps", Algorithm::jps, false},
+    {"alt", Algorithm::alt, false},          {"bidirectional bfs", Algorithm::breadthFirst, true},
+    {"bidirectional dijkstra", Algorithm::dijkstra, true}, {"bidirectional astar", Algorithm::astar, true},
+};
+
+// A stopped search is partial and leads from the start; one that does
+// not need the limit is not stopped
+void checkStopped(const WeightedGrid& grid, const SearchResult& result, const SearchResult& unlimited,
+                  Coordinates start, const SearchOptions& options, std::size_t maxExpanded,
+                  const std::string& what) {
+    if (!result.partial) {
+        check(unlimited.expanded <= maxExpanded && result.path == unlimited.path, what + " not stopped");
+        return;
+    }
+    check(!result.found() && !result.path.empty() && result.path.front() == start
+          && validPath(grid, result.path, start, result.path.back(), options), what + " partial path");
+    // BFS and JPS count steps
+    bool steps = what.compare(0, 3, "bfs") == 0 || what.compare(0, 17, "bidirectional bfs") == 0
+              || what.compare(0, 3, "jps") == 0;
+    check(near(result.cost, steps ? double(result.path.size() - 1) : pathCost(grid, result.path)),
+          what + " partial cost");
+    check(result.expanded <= maxExpanded, what + " expanded " + std::to_string(result.expanded));
+}
+
+void testLimits() {
+    std::mt19937 random(25);
+    SearchSpace space;
+    for (int map = 0; map < 8; ++map) {
+        // JPS moves in four directions on uniform steps
+        bool uniform = map % 2 == 0;
+        WeightedGrid grid = randomGrid(random, 60, 50, 0.2, uniform ? 1 : 9);
+        SearchOptions options;
+        if (!uniform) options.connectivity = Connectivity::eight;
+        grid.buildLandmarks(4, options);
+        for (int query = 0; query < 6; ++query) {
+            Coordinates start = randomCell(random, grid), goal = randomCell(random, grid);
+            for (const Limited& limited : LIMITED) {
+                if (limited.algorithm == Algorithm::jps && !uniform) continue;
+                SearchOptions used = options;
+                used.bidirectional = limited.bidirectional;
+                SearchResult unlimited = grid.search(space, limited.algorithm, start, goal, nullptr, used);
+                std::string what = describe(limited.name, start, goal, used);
+
+                // Set before the search, in the past or without time: nothing expanded
+                std::atomic<bool> cancel{true};
+                SearchOptions stopped = used;
+                stopped.limits.cancel = &cancel;
+                SearchResult cancelled = grid.search(space, limited.algorithm, start, goal, nullptr, stopped);
+                stopped = used;
+                stopped.limits.deadline = std::chrono::steady_clock::now() - std::chrono::milliseconds(1);
+                SearchResult late = grid.search(space, limited.algorithm, start, goal, nullptr, stopped);
+                stopped = used;
+                stopped.limits.budget = std::chrono::steady_clock::duration::zero();
+                SearchResult spent = grid.search(space, limited.algorithm, start, goal, nullptr, stopped);
+                for (const SearchResult* result : {&cancelled, &late, &spent}) {
+                    if (start == goal) continue;
+                    check(result->partial && result->expanded == 0 && result->path.size() == 1
+                          && result->path.front() == start, what + " stopped before the first expansion");
+                }
+
+                // A flag nobody sets and an ample budget change nothing
+                cancel = false;
+                stopped = used;
+                stopped.limits.cancel = &cancel;
+                stopped.limits.budget = std::chrono::seconds(60);
+                SearchResult ample = grid.search(space, limited.algorithm, start, goal, nullptr, stopped);
+                check(!ample.partial && ample.path == unlimited.path && ample.expanded == unlimited.expanded,
+                      what + " with ample limits");
+
+                for (std::size_t maxExpanded : {std::size_t(1), std::size_t(20), std::size_t(300)}) {
+                    stopped = used;
+                    stopped.limits.maxExpanded = maxExpanded;
+                    SearchResult capped = grid.search(space, limited.algorithm, start, goal, nullptr, stopped);
+                    checkStopped(grid, capped, unlimited, start, used, maxExpanded,
+                                 what + " within " + std::to_string(maxExpanded) + " expansions");
+                }
+            }
+        }
+    }
+}
+
+// Unlimited ARA* ends with a shortest path, limited ones with paths
+// within their bound that only get cheaper with a larger budget
+void testAnytime() {
+    std::mt19937 random(26);
+    SearchSpace space;
+    const std::vector<SearchOptions> rules = stepRules();
+    int improved = 0;
+    for (int map = 0; map < 16; ++map) {
+        unsigned maxWeight = map % 3 == 0 ? 1 : map % 3 == 1 ? 9 : 300;
+        WeightedGrid grid = randomGrid(random, 20 + int(random() % 60), 20 + int(random() % 60), 0.25, maxWeight);
+        SearchOptions options = rules[map % rules.size()];
+        options.frontier = Frontier::binaryHeap;
+        options.anytimeWeight = map % 2 ? 3 : 1.7;
+        for (int query = 0; query < 6; ++query) {
+            Coordinates start = randomCell(random, grid), goal = randomCell(random, grid);
+            SearchResult reference = grid.dijkstraSearch(space, start, goal, nullptr, options);
+            SearchResult ara = grid.search(space, Algorithm::anytime, start, goal, nullptr, options);
+            std::string what = describe("ara", start, goal, options);
+            check(ara.found() == reference.found() && validPath(grid, ara.path, start, goal, options), what + " path");
+            if (!reference.found()) continue;
+            check(near(ara.cost, reference.cost) && ara.suboptimality == 1, what + " cost "
+                  + std::to_string(ara.cost) + " instead of " + std::to_string(reference.cost));
+
+            double cost = 0, bound = 0;
+            for (std::size_t maxExpanded = 4; maxExpanded < 2 * ara.expanded; maxExpanded *= 2) {
+                SearchOptions limited = options;
+                limited.limits.maxExpanded = maxExpanded;
+                SearchResult result = grid.search(space, Algorithm::anytime, start, goal, nullptr, limited);
+                std::string within = what + " within " + std::to_string(maxExpanded) + " expansions";
+                if (result.partial) {
+                    check(cost == 0 && result.path.front() == start, within + " partial");
+                    continue;
+                }
+                check(validPath(grid, result.path, start, goal, options) && result.suboptimality >= 1
+                      && result.suboptimality <= std::max(1.0, options.anytimeWeight) + 1e-9
+                      && result.cost <= result.suboptimality * reference.cost + 1e-6, within + " bound "
+                      + std::to_string(result.suboptimality) + " for " + std::to_string(result.cost)
+                      + " over " + std::to_string(reference.cost));
+                if (cost > 0) {
+                    check(result.cost <= cost + 1e-6 && result.suboptimality <= bound + 1e-9, within + " improves "
+                          + std::to_string(result.cost) + " after " + std::to_string(cost) + ", bound "
+                          + std::to_string(result.suboptimality) + " after " + std::to_string(bound));
+                    improved += result.cost < cost - 1e-6;
+                }
+                cost = result.cost;
+                bound = result.suboptimality;
+            }
+        }
+    }
+    check(improved > 0, "larger budgets give cheaper ARA* paths");
+}
+}
+
+int main() {
+    testLimits();
+    testAnytime();
+    return finish();
+}
@@ -0,0 +1,85 @@
+// Map files: bitmaps through save, load, truncation and forged headers,
+// edits of mapped grids, and MovingAI text
+
+#include "mapfile.h"
+#include "testing.h"
+
+namespace {
+bool sameMap(const WeightedGrid& a, const WeightedGrid& b) {
+    bool same = a.width() == b.width() && a.height() == b.height() && a.weightBytes() == b.weightBytes()
+             && std::memcmp(a.bitmap(), b.bitmap(),
+                            Grid::bitmapWords(a.width(), a.height()) * sizeof(std::uint64_t)) == 0;
+    for (int cell = 0; same && cell < a.cellCount(); ++cell)
+        same = a.weight(a.coordinates(cell)) == b.weight(b.coordinates(cell));
+    return same;
+}
+
+void testBitmaps() {
+    std::string bitmap = scratchPath(".bmap");
+    std::mt19937 random(99);
+    for (unsigned maxWeight : {1u, 200u, 3000u}) {
+        WeightedGrid grid = randomGrid(random, 70, 33, 0.2, maxWeight);
+        saveBitmap(grid, bitmap);
+        WeightedGrid loaded = loadBitmap(bitmap);
+        check(sameMap(loaded, grid), "bitmap round trip with weights up to " + std::to_string(maxWeight));
+
+        // The first edit of a loaded grid writes into the private mapping
+        // instead of copying, the first one of a copy does copy
+        const std::uint64_t* bits = loaded.bitmap();
+        {
+            WeightedGrid copy = loaded;
+            copy.setObstacle({1, 1}, copy.passable({1, 1}));
+            copy.setWeight({2, 2}, 2);
+            check(copy.bitmap() != bits && sameMap(loaded, grid), "edit of a copy");
+        }
+        loaded.setObstacle({1, 1}, loaded.passable({1, 1}));
+        check(loaded.bitmap() == bits, "first edit of a loaded bitmap copies it");
+        if (loaded.hasWeights()) {
+            const void* weights = loaded.weightData();
+            loaded.setWeight({2, 2}, 2);
+            check(loaded.weightData() == weights, "first edit of loaded weights copies them");
+        }
+
+        std::string bytes = readFile(bitmap);
+        auto load = [](const std::string& path) { loadBitmap(path); };
+        checkTruncations("bitmap", bitmap, bytes, load);
+        std::string forged = bytes;
+        forged[64] |= 1; // Top left corner of the border
+        check(throws(bitmap, forged, load), "bitmap with an open border");
+        forged = bytes;
+        patch<std::uint32_t>(forged, 12, 0x7fffffff);
+        check(throws(bitmap, forged, load), "bitmap wider than an int");
+        if (grid.hasWeights()) {
+            forged = bytes;
+            std::size_t weightsAt = 64 + Grid::bitmapWords(grid.width(), grid.height()) * sizeof(std::uint64_t);
+            std::memset(&forged[weightsAt], 0, std::size_t(grid.weightBytes()));
+            check(throws(bitmap, forged, load), "bitmap with a weight of 0");
+        }
+    }
+    std::remove(bitmap.c_str());
+}
+
+void testMovingAi() {
+    auto parses = [](const std::string& text) {
+        try {
+            parseMovingAiMap(text.data(), text.size());
+        } catch (const std::runtime_error&) {
+            return false;
+        }
+        return true;
+    };
+    check(!parses("type octile\nheight 1\nwidth 2147483647\nmap\n..\n"), "map wider than an int");
+    check(!parses("type octile\nheight 70000\nwidth 70000\nmap\n"), "map with too many cells");
+    check(!parses("type octile\nheight 2\nwidth 3\nmap\n...\n..\n"), "map with a short row");
+    std::string text = "type octile\nheight 2\nwidth 3\nmap\n.@S\nT..\n";
+    WeightedGrid parsed = parseMovingAiMap(text.data(), text.size());
+    check(parsed.passable({0, 0}) && !parsed.passable({1, 0}) && parsed.weight({2, 0}) == SWAMP_WEIGHT
+          && !parsed.passable({0, 1}), "map cells");
+}
+}
+
+int main() {
+    testBitmaps();
+    testMovingAi();
+    return finish();
+}
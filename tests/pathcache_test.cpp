@@ -0,0 +1,155 @@
+// Path cache: least recently used eviction, misses after edits, parts of
+// cached paths against fresh searches, and what it refuses to keep
+
+#include "pathcache.h"
+#include "testing.h"
+
+namespace {
+bool cached(PathCache& cache, const WeightedGrid& grid, Coordinates start, Coordinates goal,
+            const SearchOptions& options = {}) {
+    SearchResult result;
+    return cache.find(grid, Algorithm::dijkstra, start, goal, options, result);
+}
+
+// Capacity 3 without sub-paths: a lookup keeps a query, an insert
+// pushes out the one used longest ago
+void testEviction() {
+    WeightedGrid grid(10, 10);
+    SearchSpace space;
+    PathCache cache(3, false);
+    Coordinates a{0, 0}, b{1, 0}, c{2, 0}, d{3, 0}, goal{9, 9};
+    for (Coordinates start : {a, b, c})
+        cache.search(grid, space, Algorithm::dijkstra, start, goal);
+    check(cache.size() == 3 && cache.misses() == 3, "cache filled");
+    check(cached(cache, grid, a, goal), "first query cached");
+    cache.search(grid, space, Algorithm::dijkstra, d, goal);
+    check(cache.size() == 3, "cache stays at its capacity");
+    check(!cached(cache, grid, b, goal), "least recently used query evicted");
+    check(cached(cache, grid, a, goal) && cached(cache, grid, c, goal) && cached(cache, grid, d, goal),
+          "recently used queries kept");
+
+    // Other options or algorithms are other queries
+    SearchOptions eight;
+    eight.connectivity = Connectivity::eight;
+    SearchResult result;
+    check(!cached(cache, grid, a, goal, eight)
+          && !cache.find(grid, Algorithm::astar, a, goal, {}, result), "options and algorithm in the key");
+
+    cache.clear();
+    check(cache.size() == 0 && cache.hits() == 0 && cache.misses() == 0 && !cached(cache, grid, a, goal),
+          "clear");
+    PathCache none(0);
+    none.search(grid, space, Algorithm::dijkstra, a, goal);
+    check(none.size() == 0, "cache of capacity 0");
+}
+
+// Results of an older version of the map miss
+void testVersions() {
+    WeightedGrid grid(12, 6);
+    SearchSpace space;
+    PathCache cache;
+    Coordinates start{0, 2}, goal{11, 2};
+    SearchResult before = cache.search(grid, space, Algorithm::dijkstra, start, goal);
+    std::uint64_t version = grid.version();
+    for (int y = 0; y < 5; ++y)
+        grid.setObstacle({5, y});
+    check(grid.version() != version, "edits change the version");
+    check(!cached(cache, grid, start, goal) && !cached(cache, grid, {1, 2}, {10, 2}),
+          "queries and sub-paths miss after an edit");
+    SearchResult after = cache.search(grid, space, Algorithm::dijkstra, start, goal);
+    SearchResult fresh = grid.search(space, Algorithm::dijkstra, start, goal);
+    check(after.path == fresh.path && near(after.cost, fresh.cost) && after.cost > before.cost,
+          "search after an edit");
+    grid.setWeight({0, 0}, 5);
+    check(!cached(cache, grid, start, goal), "query misses after a weight edit");
+}
+
+// Every answer of the cache, whole or part of a cached path, costs
+// what a fresh search does, before and after edits. The capacity is
+// small, so evictions keep the paths through each cell in step.
+void testSubPaths() {
+    std::mt19937 random(20);
+    SearchSpace space;
+    const std::vector<SearchOptions> rules = stepRules();
+    for (int map = 0; map < 12; ++map) {
+        int width = 8 + int(random() % 40), height = 8 + int(random() % 40);
+        unsigned maxWeight = map % 3 == 0 ? 1 : 9;
+        WeightedGrid grid = randomGrid(random, width, height, 0.2, maxWeight);
+        SearchOptions options = rules[map % rules.size()];
+        Algorithm algorithm = map % 3 == 0 ? Algorithm::breadthFirst : map % 3 == 1 ? Algorithm::dijkstra
+                                                                                    : Algorithm::astar;
+        PathCache cache(6);
+        for (int round = 0; round < 3; ++round) {
+            std::size_t subPathHits = cache.subPathHits();
+            for (int query = 0; query < 10; ++query) {
+                Coordinates start = randomCell(random, grid), goal = randomCell(random, grid);
+                SearchResult whole = cache.search(grid, space, algorithm, start, goal, nullptr, options);
+                if (whole.path.size() < 3) continue;
+                // Pairs along the path, in order, some of them reversed
+                for (int pair = 0; pair < 6; ++pair) {
+                    std::size_t i = random() % whole.path.size(), j = random() % whole.path.size();
+                    if (pair % 3 != 2 && i > j) std::swap(i, j);
+                    Coordinates from = whole.path[i], to = whole.path[j];
+                    SearchResult result = cache.search(grid, space, algorithm, from, to, nullptr, options);
+                    SearchResult fresh = grid.search(space, algorithm, from, to, nullptr, options);
+                    std::string what = describe(algorithmName(algorithm), from, to, options) + " from the cache";
+                    check(result.found() == fresh.found() && validPath(grid, result.path, from, to, options),
+                          what + " path");
+                    check(near(result.cost, fresh.cost), what + " cost " + std::to_string(result.cost)
+                          + " instead of " + std::to_string(fresh.cost));
+                }
+            }
+            check(cache.subPathHits() > subPathHits && cache.size() <= cache.capacity(),
+                  "sub-path hits on map " + std::to_string(map));
+            for (int edit = 0; edit < 12; ++edit)
+                randomEdit(random, grid, maxWeight);
+        }
+    }
+}
+
+// Partial results and ARA* paths above the shortest are not kept,
+// unreachable goals are
+void testRefusals() {
+    std::mt19937 random(21);
+    WeightedGrid grid = randomGrid(random, 60, 60, 0.2, 9);
+    SearchSpace space;
+    PathCache cache;
+    Coordinates start{1, 1}, goal{58, 58};
+    grid.setObstacle(start, false);
+    grid.setObstacle(goal, false);
+
+    SearchOptions limited;
+    limited.limits.maxExpanded = 10;
+    SearchResult partial = cache.search(grid, space, Algorithm::astar, start, goal, nullptr, limited);
+    check(partial.partial && cache.size() == 0, "partial result not cached");
+    SearchResult full = cache.search(grid, space, Algorithm::astar, start, goal);
+    check(full.found() && cache.size() == 1, "full result cached");
+
+    // The limits are not part of the key, a cached answer is complete
+    SearchResult hit = cache.search(grid, space, Algorithm::astar, start, goal, nullptr, limited);
+    check(cache.hits() == 1 && !hit.partial && near(hit.cost, full.cost), "limited query answered by the cache");
+
+    SearchOptions anytime;
+    anytime.limits.maxExpanded = 200;
+    SearchResult ara = cache.search(grid, space, Algorithm::anytime, start, goal, nullptr, anytime);
+    check(ara.suboptimality > 1 && cache.size() == 1, "ARA* path above the shortest not cached");
+    SearchResult forged = full;
+    forged.partial = true;
+    cache.insert(grid, Algorithm::dijkstra, start, goal, {}, forged);
+    check(cache.size() == 1, "inserted partial result not cached");
+
+    WeightedGrid walled(10, 10);
+    for (int y = 0; y < 10; ++y)
+        walled.setObstacle({5, y});
+    SearchResult unreachable = cache.search(walled, space, Algorithm::dijkstra, {0, 0}, {9, 9});
+    check(!unreachable.found() && cached(cache, walled, {0, 0}, {9, 9}), "unreachable goal cached");
+}
+}
+
+int main() {
+    testEviction();
+    testVersions();
+    testSubPaths();
+    testRefusals();
+    return finish();
+}
@@ -0,0 +1,39 @@
+// MovingAI scenario files as the runner reads them
+
+#include "scenario.h"
+#include "testing.h"
+
+namespace {
+void testScenarios() {
+    std::string path = scratchPath(".scen");
+    writeFile(path, "version 1\n"
+                    "0\tmaps/a.map\t40\t20\t1\t2\t30\t17\t33.72792206\n"
+                    "\n"
+                    "3\tmaps/a.map\t40\t20\t5\t6\t7\t8\n");
+    std::vector<Query> queries = loadScenario(path);
+    check(queries.size() == 2, "scenario lines");
+    if (queries.size() == 2) {
+        check(queries[0].start == Coordinates{1, 2} && queries[0].goal == Coordinates{30, 17}
+              && near(queries[0].referenceLength, 33.72792206), "scenario query");
+        check(queries[1].start == Coordinates{5, 6} && queries[1].goal == Coordinates{7, 8}
+              && queries[1].referenceLength == -1, "scenario query without a length");
+    }
+
+    auto load = [](const std::string& file) { loadScenario(file); };
+    check(throws(path, "version 1\n0\tmaps/a.map\t40\t20\t1\t2\t30\n", load), "scenario with a short line");
+    check(throws(path, "version 1\n0\tmaps/a.map\t40\t20\tx\t2\t30\t17\t1\n", load), "scenario with a word");
+    std::remove(path.c_str());
+    bool missing = false;
+    try {
+        loadScenario(path);
+    } catch (const std::runtime_error&) {
+        missing = true;
+    }
+    check(missing, "missing scenario");
+}
+}
+
+int main() {
+    testScenarios();
+    return finish();
+}
@@ -0,0 +1,148 @@
+// BFS, Dijkstra and A*, one way and bidirectional, against Dijkstra on a
+// binary heap, on random grids before and after edits
+
+#include "testing.h"
+
+namespace {
+// Every search on one query, against Dijkstra on a binary heap
+void checkQuery(WeightedGrid& grid, SearchSpace& space, Coordinates start, Coordinates goal,
+                SearchOptions options) {
+    options.frontier = Frontier::binaryHeap;
+    SearchResult reference = grid.dijkstraSearch(space, start, goal, nullptr, options);
+    check(validPath(grid, reference.path, start, goal, options), describe("dijkstra path", start, goal, options));
+    check(reference.path.empty() || near(reference.cost, pathCost(grid, reference.path)),
+          describe("dijkstra cost", start, goal, options));
+    // Manhattan or octile estimates never overestimate
+    check(!reference.found() || double(heuristic(start, goal, options.connectivity)) <= reference.cost * COST_SCALE,
+          describe("heuristic", start, goal, options));
+
+    // Exact on any terrain
+    auto exact = [&](const char* name, const SearchResult& result, const SearchOptions& used) {
+        check(result.found() == reference.found(), describe(name, start, goal, used) + " found");
+        check(validPath(grid, result.path, start, goal, used), describe(name, start, goal, used) + " path");
+        if (!result.found() || !reference.found()) return;
+        check(near(result.cost, reference.cost), describe(name, start, goal, used) + " cost "
+              + std::to_string(result.cost) + " instead of " + std::to_string(reference.cost));
+        check(near(result.cost, pathCost(grid, result.path)), describe(name, start, goal, used) + " path cost");
+    };
+    SearchOptions used = options;
+    for (bool bidirectional : {false, true}) {
+        used.bidirectional = bidirectional;
+        exact(bidirectional ? "bidirectional dijkstra" : "dijkstra",
+              grid.search(space, Algorithm::dijkstra, start, goal, nullptr, used), used);
+        exact(bidirectional ? "bidirectional astar" : "astar",
+              grid.search(space, Algorithm::astar, start, goal, nullptr, used), used);
+    }
+
+    // BFS in steps, which the nudge of the costs does not change, from
+    // one end or from both
+    if (!grid.hasWeights()) {
+        std::size_t steps = 0;
+        for (bool bidirectional : {false, true}) {
+            used.bidirectional = bidirectional;
+            const char* name = bidirectional ? "bidirectional bfs" : "bfs";
+            SearchResult bfs = grid.search(space, Algorithm::breadthFirst, start, goal, nullptr, used);
+            check(bfs.found() == reference.found(), describe(name, start, goal, used) + " found");
+            check(validPath(grid, bfs.path, start, goal, used), describe(name, start, goal, used) + " path");
+            if (bfs.found() && options.connectivity == Connectivity::four)
+                check(bfs.path.size() == reference.path.size(), describe(name, start, goal, used) + " steps");
+            if (!bidirectional) steps = bfs.path.size();
+            else check(bfs.path.size() == steps, describe(name, start, goal, used) + " steps one way");
+        }
+    }
+}
+
+// Random maps without weights, with 8 bit and with 16 bit ones, under
+// every step rule, then again after edits
+void testSearches() {
+    std::mt19937 random(2024);
+    SearchSpace space;
+    const std::vector<SearchOptions> rules = stepRules();
+    for (int map = 0; map < 24; ++map) {
+        int width = 6 + int(random() % 40), height = 6 + int(random() % 40);
+        unsigned maxWeight = map % 3 == 0 ? 1 : map % 3 == 1 ? 9 : 300;
+        WeightedGrid grid = randomGrid(random, width, height, 0.25, maxWeight);
+        const SearchOptions& options = rules[map % rules.size()];
+        for (int round = 0; round < 2; ++round) {
+            for (int query = 0; query < 6; ++query)
+                checkQuery(grid, space, randomCell(random, grid), randomCell(random, grid), options);
+            for (int edit = 0; edit < 12; ++edit)
+                randomEdit(random, grid, maxWeight);
+        }
+    }
+}
+
+// Weights start at 8 bits, widen to 16 and are at least 1
+void testWeights() {
+    WeightedGrid grid(5, 4);
+    grid.setWeight({1, 1}, 1);
+    check(!grid.hasWeights(), "weight 1 on a grid without weights");
+    grid.setWeight({1, 1}, 200);
+    check(grid.weightBytes() == 1 && grid.weight({1, 1}) == 200 && grid.weight({0, 0}) == 1, "8 bit weights");
+    grid.setWeight({2, 1}, 4000);
+    check(grid.weightBytes() == 2 && grid.weight({1, 1}) == 200 && grid.weight({2, 1}) == 4000, "16 bit weights");
+    grid.setWeight({3, 1}, 0);
+    grid.setWeight({3, 2}, 100000);
+    check(grid.weight({3, 1}) == 1 && grid.weight({3, 2}) == 65535, "weights clamped");
+    check(grid.cost({1, 1}, {2, 1}) == 4000 * stepCost({1, 1}, 0)
+          && grid.cost({1, 0}, {2, 1}) == 4000 * DIAGONAL_COST, "step costs times the weight");
+}
+
+// The neighbor mask against passable(), on widths around the 64 bit
+// words of the bitmap rows
+void testNeighbors() {
+    std::mt19937 random(11);
+    for (int width : {1, 2, 61, 62, 63, 64, 65, 126, 127, 128, 200}) {
+        WeightedGrid grid = randomGrid(random, width, 5, 0.4);
+        bool same = true;
+        for (int cell = 0; same && cell < grid.cellCount(); ++cell) {
+            Coordinates id = grid.coordinates(cell);
+            unsigned expected = 0;
+            for (int d = 0; d < 8; ++d) {
+                Coordinates next{id.x + Grid::DELTA[d].x, id.y + Grid::DELTA[d].y};
+                if (grid.inBounds(next) && grid.passable(next)) expected |= 1u << d;
+            }
+            std::vector<Coordinates> listed;
+            grid.forEachNeighbor(id, [&](Coordinates next, int nextCell, int direction) {
+                same = same && grid.index(next) == nextCell && next.x == id.x + Grid::DELTA[direction].x
+                    && next.y == id.y + Grid::DELTA[direction].y;
+                listed.push_back(next);
+            });
+            same = same && grid.neighborMask(id) == expected && listed == grid.neighbors(id)
+                && listed.size() == std::size_t(__builtin_popcount(expected & 15));
+        }
+        check(same, "neighbors on a width of " + std::to_string(width));
+    }
+}
+
+// The trace holds the visited cells, then the path, and starts over
+// with every search
+void testTraces() {
+    std::mt19937 random(7);
+    SearchSpace space;
+    SearchTrace trace;
+    for (int map = 0; map < 6; ++map) {
+        WeightedGrid grid = randomGrid(random, 30, 20, 0.25);
+        Coordinates start = randomCell(random, grid), goal = randomCell(random, grid);
+        for (Algorithm algorithm : {Algorithm::breadthFirst, Algorithm::dijkstra, Algorithm::astar}) {
+            SearchResult result = grid.search(space, algorithm, start, goal, &trace);
+            std::vector<Coordinates> path;
+            std::size_t visited = 0;
+            bool ordered = true;
+            for (const SearchTrace::Event& event : trace.events()) {
+                if (event.kind == SearchTrace::Kind::path) path.push_back(grid.coordinates(event.cell));
+                else ordered = ordered && path.empty() && ++visited <= std::size_t(grid.cellCount());
+            }
+            check(ordered && path == result.path, std::string(algorithmName(algorithm)) + " trace");
+        }
+    }
+}
+}
+
+int main() {
+    testSearches();
+    testWeights();
+    testNeighbors();
+    testTraces();
+    return finish();
+}
@@ -0,0 +1,197 @@
+// Histogram buckets and quantiles against sorted values, and search
+// statistics through record and JSON
+
+#include "statistics.h"
+#include "testing.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+// Just enough of a JSON parser to tell whether text is one value
+class JsonReader {
+public:
+    explicit JsonReader(const std::string& text) : text(text) {}
+
+    bool valid() {
+        return value() && (space(), at == this->text.size());
+    }
+
+private:
+    const std::string& text;
+    std::size_t at = 0;
+
+    void space() {
+        while (at < text.size() && std::strchr(" \t\r\n", text[at])) ++at;
+    }
+    bool literal(const char* word) {
+        std::size_t length = std::strlen(word);
+        if (text.compare(at, length, word) != 0) return false;
+        at += length;
+        return true;
+    }
+    bool string() {
+        if (at >= text.size() || text[at] != '"') return false;
+        for (++at; at < text.size() && text[at] != '"'; ++at)
+            if (text[at] == '\\') ++at;
+        return at++ < text.size();
+    }
+    bool number() {
+        const char* begin = text.c_str() + at;
+        if (*begin != '-' && !std::isdigit(static_cast<unsigned char>(*begin))) return false;
+        char* end = nullptr;
+        std::strtod(begin, &end);
+        at += std::size_t(end - begin);
+        return end != begin;
+    }
+    template <class Item>
+    bool list(char close, Item item) {
+        ++at;
+        space();
+        if (at < text.size() && text[at] == close) return ++at, true;
+        for (;;) {
+            if (!item()) return false;
+            space();
+            if (at >= text.size()) return false;
+            if (text[at++] == close) return true;
+            if (text[at - 1] != ',') return false;
+        }
+    }
+    bool value() {
+        space();
+        if (at >= text.size()) return false;
+        switch (text[at]) {
+            case '{':
+                return list('}', [this]() {
+                    space();
+                    if (!string()) return false;
+                    space();
+                    return at < text.size() && text[at++] == ':' && value();
+                });
+            case '[': return list(']', [this]() { return value(); });
+            case '"': return string();
+            default:  return literal("true") || literal("false") || literal("null") || number();
+        }
+    }
+};
+
+// Buckets grow with the value and start at their lower bound
+void testBuckets() {
+    bool monotone = true, bounded = true;
+    int previous = 0;
+    for (std::uint64_t value = 0; value < 5000; ++value) {
+        int bucket = Histogram::bucket(value);
+        monotone = monotone && bucket >= previous && bucket <= previous + 1;
+        bounded = bounded && Histogram::lowerBound(bucket) <= value && value < Histogram::lowerBound(bucket + 1);
+        previous = bucket;
+    }
+    check(monotone, "buckets grow one at a time");
+    check(bounded, "small values within their bucket");
+
+    // Around every power of two, up to the largest value
+    bounded = true;
+    for (int octave = 2; octave < 64; ++octave) {
+        for (std::uint64_t value : {(std::uint64_t(1) << octave) - 1, std::uint64_t(1) << octave,
+                                    (std::uint64_t(1) << octave) + (std::uint64_t(1) << (octave - 2)) * 3}) {
+            int bucket = Histogram::bucket(value);
+            bounded = bounded && bucket < Histogram::BUCKETS && Histogram::lowerBound(bucket) <= value
+                   && (bucket + 1 == Histogram::BUCKETS || value < Histogram::lowerBound(bucket + 1));
+        }
+    }
+    check(bounded && Histogram::bucket(~std::uint64_t(0)) == Histogram::BUCKETS - 1, "large values within their bucket");
+    bounded = true;
+    for (int bucket = 0; bucket < Histogram::BUCKETS; ++bucket)
+        bounded = bounded && Histogram::bucket(Histogram::lowerBound(bucket)) == bucket;
+    check(bounded, "lower bounds in their own bucket");
+}
+
+// Quantiles lie in the bucket of the true one, never above the largest
+// value, and rise with q
+void testQuantiles() {
+    std::mt19937 random(24);
+    Histogram empty;
+    check(empty.quantile(0.5) == 0 && empty.count() == 0, "quantile of an empty histogram");
+    for (int round = 0; round < 20; ++round) {
+        Histogram histogram;
+        std::vector<std::uint64_t> values;
+        int count = 1 + int(random() % 2000);
+        int bits = 1 + int(random() % 40);
+        for (int i = 0; i < count; ++i) {
+            std::uint64_t value = std::uint64_t(random()) << 32 | random();
+            values.push_back(value >> (64 - bits));
+            histogram.add(values.back());
+        }
+        std::sort(values.begin(), values.end());
+        std::uint64_t sum = 0;
+        for (std::uint64_t value : values)
+            sum += value;
+        check(histogram.count() == values.size() && histogram.sum() == sum && histogram.max() == values.back(),
+              "histogram totals");
+        bool within = true;
+        std::uint64_t previous = 0;
+        for (double q : {0.0, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999, 1.0}) {
+            std::size_t rank = std::max<std::size_t>(1, std::size_t(std::ceil(q * double(values.size()))));
+            std::uint64_t exact = values[rank - 1], estimate = histogram.quantile(q);
+            int bucket = Histogram::bucket(exact);
+            within = within && estimate >= Histogram::lowerBound(bucket) && estimate <= histogram.max()
+                  && (bucket + 1 == Histogram::BUCKETS || estimate < Histogram::lowerBound(bucket + 1))
+                  && estimate >= previous;
+            previous = estimate;
+        }
+        check(within, "quantiles of " + std::to_string(count) + " values of " + std::to_string(bits) + " bits");
+        histogram.clear();
+        check(histogram.count() == 0 && histogram.max() == 0 && histogram.quantile(0.5) == 0, "histogram clear");
+    }
+}
+
+// Recorded queries come back in the JSON, which parses, and searches
+// record themselves in builds with PATHSEARCH_STATS
+void testRecords() {
+    SearchStatistics statistics;
+    check(JsonReader(statistics.json()).valid(), "JSON without queries");
+    SearchResult found;
+    found.path = {{0, 0}, {1, 0}};
+    found.expanded = 12;
+    found.stats.pushes = 30;
+    SearchResult partial = found;
+    partial.partial = true;
+    statistics.record(Algorithm::astar, found, 15.5);
+    statistics.record(Algorithm::astar, partial, 40);
+    statistics.record(Algorithm::dijkstra, SearchResult(), 2);
+    check(statistics.queries(Algorithm::astar) == 2 && statistics.queries(Algorithm::dijkstra) == 1
+          && statistics.queries(Algorithm::jps) == 0, "queries recorded");
+    check(statistics.expansions(Algorithm::astar).max() == 12
+          && statistics.latencies(Algorithm::astar).max() == 40000, "histograms of records");
+    std::string json = statistics.json();
+    check(JsonReader(json).valid(), "JSON parses: " + json);
+    check(json.find("\"astar\": {\"queries\": 2, \"found\": 1, \"partial\": 1, \"pushes\": 60,") != std::string::npos
+          && json.find("\"dijkstra\": {\"queries\": 1, \"found\": 0,") != std::string::npos
+          && json.find("\"jps\"") == std::string::npos, "JSON of the records");
+    check(json.find(SEARCH_STATS ? "\"stats\": true" : "\"stats\": false") == 1, "JSON names the build");
+    statistics.clear();
+    check(statistics.queries(Algorithm::astar) == 0 && statistics.json().find("astar") == std::string::npos,
+          "statistics clear");
+
+    // Searches fill their counters and record themselves
+    std::mt19937 random(5);
+    WeightedGrid grid = randomGrid(random, 40, 40, 0.2);
+    SearchSpace space;
+    searchStatistics().clear();
+    SearchResult result = grid.search(space, Algorithm::dijkstra, randomCell(random, grid), randomCell(random, grid));
+    if (SEARCH_STATS) {
+        check(result.stats.pushes > 0 && result.stats.relaxations > 0, "search counters");
+        check(searchStatistics().queries(Algorithm::dijkstra) == 1, "search recorded");
+        check(JsonReader(searchStatistics().json()).valid(), "JSON of a search parses");
+    } else {
+        check(result.stats.pushes == 0 && searchStatistics().queries(Algorithm::dijkstra) == 0,
+              "counters compiled away");
+    }
+}
+}
+
+int main() {
+    testBuckets();
+    testQuantiles();
+    testRecords();
+    return finish();
+}
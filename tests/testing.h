@@ -0,0 +1,167 @@
+#ifndef TESTING_H
+#define TESTING_H
+
+// Shared by the headless tests, one program per part of the library:
+// a check counter, random maps and checks of paths against the grid
+
+#include "grid.h"
+
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+inline int failures = 0;
+inline int checks = 0;
+
+inline void check(bool condition, const std::string& what) {
+    ++checks;
+    if (condition) return;
+    // The first few are enough to go on
+    if (++failures <= 20) std::fprintf(stderr, "FAILED: %s\n", what.c_str());
+}
+
+// Exit status of a test program
+inline int finish() {
+    std::printf("%d checks, %d failed\n", checks, failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+inline std::string describe(const char* name, Coordinates start, Coordinates goal,
+                            const SearchOptions& options) {
+    return std::string(name) + " " + std::to_string(start.x) + "," + std::to_string(start.y) + " -> "
+         + std::to_string(goal.x) + "," + std::to_string(goal.y) + " connectivity "
+         + (options.connectivity == Connectivity::four ? "4" : "8") + " corners "
+         + std::to_string(int(options.cornerCutting)) + " frontier " + frontierName(options.frontier);
+}
+
+// Steps between neighbors under options, open cells only past the
+// start, which may be inside an obstacle
+inline bool validPath(const WeightedGrid& grid, const std::vector<Coordinates>& path, Coordinates start,
+                      Coordinates goal, const SearchOptions& options) {
+    if (path.empty()) return true;
+    if (path.front() != start || path.back() != goal) return false;
+    for (std::size_t i = 1; i < path.size(); ++i) {
+        Coordinates from = path[i - 1], to = path[i];
+        int dx = to.x - from.x, dy = to.y - from.y;
+        if (!grid.passable(to) || std::abs(dx) > 1 || std::abs(dy) > 1 || (dx == 0 && dy == 0)) return false;
+        if (dx != 0 && dy != 0) {
+            if (options.connectivity == Connectivity::four) return false;
+            bool horizontal = grid.passable({from.x + dx, from.y});
+            bool vertical = grid.passable({from.x, from.y + dy});
+            if (options.cornerCutting == CornerCutting::never && !(horizontal && vertical)) return false;
+            if (options.cornerCutting == CornerCutting::oneOpen && !(horizontal || vertical)) return false;
+        }
+    }
+    return true;
+}
+
+inline double pathCost(const WeightedGrid& grid, const std::vector<Coordinates>& path) {
+    Cost total = 0;
+    for (std::size_t i = 1; i < path.size(); ++i)
+        total += grid.cost(path[i - 1], path[i]);
+    return double(total) / COST_SCALE;
+}
+
+inline bool near(double a, double b, double tolerance = 1e-6) {
+    return std::fabs(a - b) <= tolerance;
+}
+
+// Every step rule of SearchOptions
+inline std::vector<SearchOptions> stepRules() {
+    std::vector<SearchOptions> rules(4);
+    rules[1].connectivity = rules[2].connectivity = rules[3].connectivity = Connectivity::eight;
+    rules[2].cornerCutting = CornerCutting::oneOpen;
+    rules[3].cornerCutting = CornerCutting::always;
+    return rules;
+}
+
+// A third of the open cells get a weight up to maxWeight, if above 1
+inline WeightedGrid randomGrid(std::mt19937& random, int width, int height, double obstacles,
+                               unsigned maxWeight = 1) {
+    WeightedGrid grid(width, height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (std::uniform_real_distribution<double>(0, 1)(random) < obstacles) grid.setObstacle({x, y});
+            else if (maxWeight > 1 && random() % 3 == 0) grid.setWeight({x, y}, 1 + random() % maxWeight);
+        }
+    }
+    return grid;
+}
+
+inline Coordinates randomCell(std::mt19937& random, const WeightedGrid& grid) {
+    for (int attempt = 0; attempt < 1000; ++attempt) {
+        Coordinates id{int(random() % grid.width()), int(random() % grid.height())};
+        if (grid.passable(id)) return id;
+    }
+    return Coordinates{0, 0};
+}
+
+// Opens, closes or reweighs a random cell
+inline void randomEdit(std::mt19937& random, WeightedGrid& grid, unsigned maxWeight = 1) {
+    Coordinates id{int(random() % grid.width()), int(random() % grid.height())};
+    if (random() % 2) grid.setObstacle(id, random() % 3 != 0);
+    else if (maxWeight > 1) grid.setWeight(id, 1 + random() % maxWeight);
+    else grid.setObstacle(id, false);
+}
+
+// Files
+
+// Unique to the test program, so tests may run in parallel
+inline std::string scratchPath(const std::string& suffix) {
+    return "/tmp/pathsearch-test-" + std::to_string(::getpid()) + suffix;
+}
+
+inline std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+inline void writeFile(const std::string& path, const std::string& bytes) {
+    std::ofstream(path, std::ios::binary).write(bytes.data(), std::streamsize(bytes.size()));
+}
+
+// Loading a proper prefix of a file has to throw, without reading
+// outside of it
+template <class Load>
+void checkTruncations(const std::string& name, const std::string& path, const std::string& bytes, Load load) {
+    std::string scratch = path + ".cut";
+    int loaded = 0;
+    // Every length around the header and the ends, a stride in between
+    for (std::size_t size = 0; size < bytes.size(); size += size < 96 || bytes.size() - size < 96 ? 1 : 61) {
+        writeFile(scratch, bytes.substr(0, size));
+        try {
+            load(scratch);
+            ++loaded;
+        } catch (const std::runtime_error&) {
+        }
+    }
+    check(loaded == 0, name + " loads truncated files");
+    std::remove(scratch.c_str());
+}
+
+template <class Load>
+bool throws(const std::string& path, const std::string& bytes, Load load) {
+    writeFile(path, bytes);
+    try {
+        load(path);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+template <class T>
+void patch(std::string& bytes, std::size_t offset, T value) {
+    std::memcpy(&bytes[offset], &value, sizeof(value));
+}
+
+#endif // TESTING_H
@@ -0,0 +1,61 @@
+// The wavefront BFS and distance fields against a plain BFS, on narrow
+// maps and on rows of many words, with the AVX2 and the scalar kernel
+
+#include "testing.h"
+
+#include <queue>
+
+namespace {
+// Steps from source over open cells, four directions
+std::vector<int> plainDistances(const WeightedGrid& grid, Coordinates source) {
+    std::vector<int> distances(std::size_t(grid.cellCount()), -1);
+    std::queue<Coordinates> queue;
+    distances[grid.index(source)] = 0;
+    queue.push(source);
+    while (!queue.empty()) {
+        Coordinates id = queue.front();
+        queue.pop();
+        for (int d = 0; d < 4; ++d) {
+            Coordinates next{id.x + Grid::DELTA[d].x, id.y + Grid::DELTA[d].y};
+            if (!grid.inBounds(next) || !grid.passable(next) || distances[grid.index(next)] >= 0) continue;
+            distances[grid.index(next)] = distances[grid.index(id)] + 1;
+            queue.push(next);
+        }
+    }
+    return distances;
+}
+
+void testWavefront(const char* kernel) {
+    std::mt19937 random(12);
+    SearchSpace space;
+    SearchOptions options;
+    for (int map = 0; map < 12; ++map) {
+        // Up to 9 words a row, so the kernels work on whole blocks of 4
+        int width = map < 4 ? 5 + int(random() % 60) : 257 + int(random() % 300);
+        int height = 5 + int(random() % 40);
+        WeightedGrid grid = randomGrid(random, width, height, map % 3 == 0 ? 0.05 : 0.3);
+        std::string name = std::string(kernel) + " kernel on " + std::to_string(width) + "x" + std::to_string(height);
+        for (int query = 0; query < 4; ++query) {
+            Coordinates source = randomCell(random, grid);
+            check(grid.distanceField(source) == plainDistances(grid, source), name + " distance field");
+
+            Coordinates goal = randomCell(random, grid);
+            SearchResult bfs = grid.search(space, Algorithm::breadthFirst, source, goal, nullptr, options);
+            SearchResult wave = grid.search(space, Algorithm::wavefront, source, goal, nullptr, options);
+            check(wave.found() == bfs.found() && wave.path.size() == bfs.path.size()
+                  && validPath(grid, wave.path, source, goal, options), describe("wavefront", source, goal, options));
+        }
+    }
+}
+}
+
+int main() {
+    if (Grid::wavefrontSimd()) {
+        testWavefront("avx2");
+        Grid::setWavefrontSimd(false);
+    } else {
+        std::printf("No AVX2, only the scalar kernel is checked\n");
+    }
+    testWavefront("scalar");
+    return finish();
+}